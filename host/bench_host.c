@@ -0,0 +1,121 @@
+/*
+ * Host build of the headless benchmark.
+ * Links race_core and race_bench as the app does and runs them off the
+ * device. Exits non-zero when the core allocates during a run, a replay
+ * does not play back to the same result, or the step rate drops below
+ * the optional floor given on the command line.
+ *
+ * usage: bench_host [steps] [min_steps_per_sec]
+ */
+
+#include "race_bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define HOST_STEPS 2000000
+#define HOST_SEED 12345
+#define REPLAY_SEED 777
+
+// ─── Allocation Counter ─────────────────────────────────────────────────────
+// Linked with --wrap, so every malloc/free in the process lands here.
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+void __real_free(void* p);
+
+static bool counting;
+static uint32_t allocs;
+static uint32_t frees;
+
+void* __wrap_malloc(size_t size) {
+    if(counting) allocs++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    if(counting) allocs++;
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+    if(counting) allocs++;
+    return __real_realloc(p, size);
+}
+
+void __wrap_free(void* p) {
+    if(counting && p) frees++;
+    __real_free(p);
+}
+
+// ─── Clock ──────────────────────────────────────────────────────────────────
+
+// Nanoseconds stand in for cycles; only differences are used
+static uint32_t host_clock(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)t.tv_sec * 1000000000u + (uint32_t)t.tv_nsec;
+}
+
+// ─── Checks ─────────────────────────────────────────────────────────────────
+
+static RaceSim sim;
+
+static uint32_t input_rng(uint32_t* x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+// Records a run with random lane changes, then plays it back
+static bool replay_matches(void) {
+    race_sim_start(&sim, DiffNormal, REPLAY_SEED);
+    uint32_t x = 5;
+    while(sim.running) {
+        uint32_t r = input_rng(&x);
+        if(r % 20 == 0) race_sim_change_lane(&sim, (r >> 8) & 1 ? 1 : -1);
+        race_sim_step(&sim);
+    }
+    uint32_t score = sim.score;
+    uint32_t steps = sim.tick_count;
+    race_sim_start_playback(&sim);
+    while(sim.running) race_sim_step(&sim);
+    printf("replay: record %u/%u playback %u/%u\n", score, steps, sim.score, sim.tick_count);
+    return sim.score == score && sim.tick_count == steps;
+}
+
+int main(int argc, char** argv) {
+    uint32_t steps = argc > 1 ? strtoul(argv[1], NULL, 0) : HOST_STEPS;
+    uint32_t min_rate = argc > 2 ? strtoul(argv[2], NULL, 0) : 0;
+    bool ok = true;
+
+    RaceBenchResult res;
+    counting = true;
+    race_bench_run(&sim, steps, HOST_SEED, host_clock, &res);
+    counting = false;
+
+    uint64_t rate = res.total_cycles ? (uint64_t)res.steps * 1000000000u / res.total_cycles : 0;
+    printf("steps: %u runs: %u\n", res.steps, res.runs);
+    printf("steps/s: %llu avg: %llu ns worst: %u ns\n",
+           (unsigned long long)rate,
+           (unsigned long long)(res.steps ? res.total_cycles / res.steps : 0),
+           res.worst_cycles);
+    printf("allocs: %u frees: %u\n", allocs, frees);
+
+    if(allocs || frees) {
+        printf("FAIL: the core allocated during the run\n");
+        ok = false;
+    }
+    if(rate < min_rate) {
+        printf("FAIL: below %u steps/s\n", min_rate);
+        ok = false;
+    }
+    if(!replay_matches()) {
+        printf("FAIL: replay diverged\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
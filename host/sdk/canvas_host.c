@@ -0,0 +1,163 @@
+/*
+ * Software canvas for host builds.
+ * A 1bpp frame buffer with the drawing calls race_game.c uses, so its draw
+ * code runs, and can be timed, off the device. Fonts are stand-ins: each
+ * glyph is a fixed-size cell filled from the character code, which keeps
+ * the per-character cost without shipping the firmware fonts.
+ */
+
+#include <gui/gui.h>
+
+#include <string.h>
+
+struct Canvas {
+    uint8_t width;
+    uint8_t height;
+    uint8_t stride; // Bytes per row
+    Color color;
+    Font font;
+    uint8_t* fb; // Row-major, LSB first
+};
+
+typedef struct {
+    uint8_t w; // Advance, one column of spacing included
+    uint8_t h; // Rows above the baseline
+} FontCell;
+
+static const FontCell font_cells[] = {
+    [FontPrimary] = {6, 8},
+    [FontSecondary] = {5, 7},
+    [FontKeyboard] = {6, 8},
+    [FontBigNumbers] = {11, 15},
+};
+
+Canvas* canvas_host_alloc(uint8_t width, uint8_t height) {
+    Canvas* c = calloc(1, sizeof(Canvas));
+    c->width = width;
+    c->height = height;
+    c->stride = (width + 7) / 8;
+    c->color = ColorBlack;
+    c->font = FontSecondary;
+    c->fb = calloc(c->stride * height, 1);
+    return c;
+}
+
+void canvas_host_free(Canvas* c) {
+    free(c->fb);
+    free(c);
+}
+
+// ─── Pixels ─────────────────────────────────────────────────────────────────
+
+static void pixel(Canvas* c, int32_t x, int32_t y) {
+    if(x < 0 || y < 0 || x >= c->width || y >= c->height) return;
+    uint8_t* b = &c->fb[y * c->stride + x / 8];
+    uint8_t m = 1 << (x % 8);
+    if(c->color == ColorBlack)
+        *b |= m;
+    else if(c->color == ColorWhite)
+        *b &= ~m;
+    else
+        *b ^= m;
+}
+
+static void hline(Canvas* c, int32_t x, int32_t y, int32_t w) {
+    for(int32_t i = 0; i < w; i++) pixel(c, x + i, y);
+}
+
+static void vline(Canvas* c, int32_t x, int32_t y, int32_t h) {
+    for(int32_t i = 0; i < h; i++) pixel(c, x, y + i);
+}
+
+void canvas_clear(Canvas* c) {
+    memset(c->fb, 0, c->stride * c->height);
+    c->color = ColorBlack;
+}
+
+void canvas_set_color(Canvas* c, Color color) {
+    c->color = color;
+}
+
+void canvas_set_font(Canvas* c, Font font) {
+    c->font = font;
+}
+
+void canvas_draw_dot(Canvas* c, int32_t x, int32_t y) {
+    pixel(c, x, y);
+}
+
+// ─── Shapes ─────────────────────────────────────────────────────────────────
+
+void canvas_draw_box(Canvas* c, int32_t x, int32_t y, size_t w, size_t h) {
+    for(size_t j = 0; j < h; j++) hline(c, x, y + j, w);
+}
+
+void canvas_draw_frame(Canvas* c, int32_t x, int32_t y, size_t w, size_t h) {
+    if(!w || !h) return;
+    hline(c, x, y, w);
+    if(h > 1) hline(c, x, y + h - 1, w);
+    if(h > 2) {
+        vline(c, x, y + 1, h - 2);
+        if(w > 1) vline(c, x + w - 1, y + 1, h - 2);
+    }
+}
+
+// Corners are cut diagonally rather than rounded
+void canvas_draw_rframe(Canvas* c, int32_t x, int32_t y, size_t w, size_t h, size_t r) {
+    if(w < 2 * r + 1 || h < 2 * r + 1) {
+        canvas_draw_frame(c, x, y, w, h);
+        return;
+    }
+    hline(c, x + r, y, w - 2 * r);
+    hline(c, x + r, y + h - 1, w - 2 * r);
+    vline(c, x, y + r, h - 2 * r);
+    vline(c, x + w - 1, y + r, h - 2 * r);
+    for(size_t i = 1; i < r; i++) {
+        pixel(c, x + r - i, y + i);
+        pixel(c, x + w - 1 - r + i, y + i);
+        pixel(c, x + r - i, y + h - 1 - i);
+        pixel(c, x + w - 1 - r + i, y + h - 1 - i);
+    }
+}
+
+void canvas_draw_xbm(Canvas* c, int32_t x, int32_t y, size_t w, size_t h, const uint8_t* bits) {
+    size_t stride = (w + 7) / 8;
+    for(size_t j = 0; j < h; j++) {
+        const uint8_t* row = bits + j * stride;
+        for(size_t i = 0; i < w; i++)
+            if(row[i / 8] & (1 << (i % 8))) pixel(c, x + i, y + j);
+    }
+}
+
+// ─── Text ───────────────────────────────────────────────────────────────────
+
+uint16_t canvas_string_width(Canvas* c, const char* str) {
+    size_t n = strlen(str);
+    return n ? n * font_cells[c->font].w - 1 : 0;
+}
+
+// `y` is the baseline
+void canvas_draw_str(Canvas* c, int32_t x, int32_t y, const char* str) {
+    const FontCell* f = &font_cells[c->font];
+    for(; *str; str++, x += f->w) {
+        uint8_t code = *str;
+        if(code == ' ') continue;
+        for(uint8_t j = 0; j < f->h; j++)
+            for(uint8_t i = 0; i + 1 < f->w; i++)
+                if((code >> ((i + j) % 7)) & 1) pixel(c, x + i, y - f->h + 1 + j);
+    }
+}
+
+void canvas_draw_str_aligned(Canvas* c, int32_t x, int32_t y, Align h, Align v, const char* str) {
+    const FontCell* f = &font_cells[c->font];
+    uint16_t w = canvas_string_width(c, str);
+    if(h == AlignRight)
+        x -= w;
+    else if(h == AlignCenter)
+        x -= w / 2;
+    if(v == AlignTop)
+        y += f->h - 1;
+    else if(v == AlignCenter)
+        y += f->h / 2;
+    canvas_draw_str(c, x, y, str);
+}
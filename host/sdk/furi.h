@@ -0,0 +1,82 @@
+/*
+ * Host stand-in for the parts of the Furi API race_game.c uses.
+ * Enough to compile the app unchanged and to call its drawing and
+ * persistence code from a host program; threads, queues and timers are
+ * inert (see furi_host.c).
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define UNUSED(x) (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+#define FURI_PACKED __attribute__((packed))
+#define furi_check(x) ((x) ? (void)0 : abort())
+#define furi_assert(x) furi_check(x)
+#define FURI_LOG_I(tag, fmt, ...) printf("[%s] " fmt "\n", tag, ##__VA_ARGS__)
+#define FURI_LOG_E(tag, fmt, ...) printf("[%s] " fmt "\n", tag, ##__VA_ARGS__)
+#define FURI_LOG_D(tag, fmt, ...) printf("[%s] " fmt "\n", tag, ##__VA_ARGS__)
+#define APP_DATA_PATH(p) p // Files land in the working directory
+
+typedef enum { FuriStatusOk = 0, FuriStatusError = -1, FuriStatusErrorTimeout = -2 } FuriStatus;
+#define FuriWaitForever 0xFFFFFFFFU
+
+// ─── Message Queue ──────────────────────────────────────────────────────────
+
+typedef struct FuriMessageQueue FuriMessageQueue;
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size);
+void furi_message_queue_free(FuriMessageQueue* q);
+FuriStatus furi_message_queue_put(FuriMessageQueue* q, const void* msg, uint32_t timeout);
+FuriStatus furi_message_queue_get(FuriMessageQueue* q, void* msg, uint32_t timeout);
+
+// ─── Timer ──────────────────────────────────────────────────────────────────
+
+typedef enum { FuriTimerTypeOnce, FuriTimerTypePeriodic } FuriTimerType;
+typedef struct FuriTimer FuriTimer;
+typedef void (*FuriTimerCallback)(void* ctx);
+FuriTimer* furi_timer_alloc(FuriTimerCallback cb, FuriTimerType type, void* ctx);
+void furi_timer_free(FuriTimer* t);
+FuriStatus furi_timer_start(FuriTimer* t, uint32_t ticks);
+FuriStatus furi_timer_stop(FuriTimer* t);
+
+// ─── Thread ─────────────────────────────────────────────────────────────────
+
+typedef enum { FuriFlagWaitAny = 0, FuriFlagWaitAll = 1, FuriFlagNoClear = 2 } FuriFlag;
+#define FuriFlagError 0x80000000U
+
+typedef struct FuriThread FuriThread;
+typedef void* FuriThreadId;
+typedef int32_t (*FuriThreadCallback)(void* ctx);
+FuriThread* furi_thread_alloc_ex(const char* name, uint32_t stack, FuriThreadCallback cb, void* ctx);
+void furi_thread_start(FuriThread* t);
+bool furi_thread_join(FuriThread* t);
+void furi_thread_free(FuriThread* t);
+FuriThreadId furi_thread_get_id(FuriThread* t);
+FuriThreadId furi_thread_get_current_id(void);
+uint32_t furi_thread_flags_set(FuriThreadId id, uint32_t flags);
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout);
+uint32_t furi_thread_get_stack_space(FuriThreadId id);
+
+// ─── Mutex ──────────────────────────────────────────────────────────────────
+
+typedef enum { FuriMutexTypeNormal } FuriMutexType;
+typedef struct FuriMutex FuriMutex;
+FuriMutex* furi_mutex_alloc(FuriMutexType type);
+void furi_mutex_free(FuriMutex* m);
+FuriStatus furi_mutex_acquire(FuriMutex* m, uint32_t timeout);
+FuriStatus furi_mutex_release(FuriMutex* m);
+
+// ─── Kernel ─────────────────────────────────────────────────────────────────
+
+uint32_t furi_get_tick(void); // Milliseconds
+uint32_t furi_ms_to_ticks(uint32_t ms);
+uint32_t furi_kernel_get_tick_frequency(void);
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
+size_t memmgr_get_free_heap(void);
+size_t memmgr_get_minimum_free_heap(void);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <furi.h>
+
+// The cycle counter reads the host clock in nanoseconds, so one
+// "instruction" per nanosecond keeps the app's us conversions right
+typedef struct {
+    uint32_t CYCCNT;
+} DWT_Type;
+
+DWT_Type* furi_host_dwt(void);
+#define DWT furi_host_dwt()
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <furi.h>
+
+void furi_hal_vibro_on(bool on);
@@ -0,0 +1,302 @@
+/*
+ * Host implementations behind the stand-in Furi headers.
+ * Nothing here runs concurrently: threads are never started, queues are
+ * always empty and timers never fire. A host program calls the app's
+ * functions directly instead. Storage maps onto host files.
+ */
+
+#include <furi.h>
+#include <furi_hal_cortex.h>
+#include <furi_hal_speaker.h>
+#include <furi_hal_vibro.h>
+#include <gui/gui.h>
+#include <storage/storage.h>
+
+#include <stdio.h>
+#include <time.h>
+
+// ─── Handles ────────────────────────────────────────────────────────────────
+// Every opaque handle is the same inert object
+
+static uint8_t handle;
+#define HANDLE(type) ((type*)&handle)
+
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size) {
+    UNUSED(msg_count);
+    UNUSED(msg_size);
+    return HANDLE(FuriMessageQueue);
+}
+
+void furi_message_queue_free(FuriMessageQueue* q) {
+    UNUSED(q);
+}
+
+FuriStatus furi_message_queue_put(FuriMessageQueue* q, const void* msg, uint32_t timeout) {
+    UNUSED(q);
+    UNUSED(msg);
+    UNUSED(timeout);
+    return FuriStatusOk; // Dropped: no thread would take it
+}
+
+FuriStatus furi_message_queue_get(FuriMessageQueue* q, void* msg, uint32_t timeout) {
+    UNUSED(q);
+    UNUSED(msg);
+    UNUSED(timeout);
+    return FuriStatusErrorTimeout;
+}
+
+FuriTimer* furi_timer_alloc(FuriTimerCallback cb, FuriTimerType type, void* ctx) {
+    UNUSED(cb);
+    UNUSED(type);
+    UNUSED(ctx);
+    return HANDLE(FuriTimer);
+}
+
+void furi_timer_free(FuriTimer* t) {
+    UNUSED(t);
+}
+
+FuriStatus furi_timer_start(FuriTimer* t, uint32_t ticks) {
+    UNUSED(t);
+    UNUSED(ticks);
+    return FuriStatusOk;
+}
+
+FuriStatus furi_timer_stop(FuriTimer* t) {
+    UNUSED(t);
+    return FuriStatusOk;
+}
+
+FuriThread* furi_thread_alloc_ex(const char* name, uint32_t stack, FuriThreadCallback cb, void* ctx) {
+    UNUSED(name);
+    UNUSED(stack);
+    UNUSED(cb);
+    UNUSED(ctx);
+    return HANDLE(FuriThread);
+}
+
+void furi_thread_start(FuriThread* t) {
+    UNUSED(t);
+}
+
+bool furi_thread_join(FuriThread* t) {
+    UNUSED(t);
+    return true;
+}
+
+void furi_thread_free(FuriThread* t) {
+    UNUSED(t);
+}
+
+FuriThreadId furi_thread_get_id(FuriThread* t) {
+    return t;
+}
+
+FuriThreadId furi_thread_get_current_id(void) {
+    return &handle;
+}
+
+uint32_t furi_thread_flags_set(FuriThreadId id, uint32_t flags) {
+    UNUSED(id);
+    return flags;
+}
+
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    UNUSED(flags);
+    UNUSED(options);
+    UNUSED(timeout);
+    return FuriFlagError | FuriStatusErrorTimeout;
+}
+
+uint32_t furi_thread_get_stack_space(FuriThreadId id) {
+    UNUSED(id);
+    return 0;
+}
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    UNUSED(type);
+    return HANDLE(FuriMutex);
+}
+
+void furi_mutex_free(FuriMutex* m) {
+    UNUSED(m);
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex* m, uint32_t timeout) {
+    UNUSED(m);
+    UNUSED(timeout);
+    return FuriStatusOk;
+}
+
+FuriStatus furi_mutex_release(FuriMutex* m) {
+    UNUSED(m);
+    return FuriStatusOk;
+}
+
+void* furi_record_open(const char* name) {
+    UNUSED(name);
+    return &handle;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
+
+size_t memmgr_get_free_heap(void) {
+    return 0;
+}
+
+size_t memmgr_get_minimum_free_heap(void) {
+    return 0;
+}
+
+// ─── Clock ──────────────────────────────────────────────────────────────────
+
+static uint64_t now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + t.tv_nsec;
+}
+
+uint32_t furi_get_tick(void) {
+    return now_ns() / 1000000;
+}
+
+uint32_t furi_ms_to_ticks(uint32_t ms) {
+    return ms;
+}
+
+uint32_t furi_kernel_get_tick_frequency(void) {
+    return 1000;
+}
+
+DWT_Type* furi_host_dwt(void) {
+    static DWT_Type dwt;
+    dwt.CYCCNT = now_ns();
+    return &dwt;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 1000;
+}
+
+// ─── Sound, Vibration ───────────────────────────────────────────────────────
+
+bool furi_hal_speaker_acquire(uint32_t timeout) {
+    UNUSED(timeout);
+    return false;
+}
+
+void furi_hal_speaker_release(void) {
+}
+
+void furi_hal_speaker_start(float frequency, float volume) {
+    UNUSED(frequency);
+    UNUSED(volume);
+}
+
+void furi_hal_speaker_stop(void) {
+}
+
+void furi_hal_vibro_on(bool on) {
+    UNUSED(on);
+}
+
+// ─── View Port ──────────────────────────────────────────────────────────────
+
+ViewPort* view_port_alloc(void) {
+    return HANDLE(ViewPort);
+}
+
+void view_port_free(ViewPort* vp) {
+    UNUSED(vp);
+}
+
+void view_port_set_orientation(ViewPort* vp, ViewPortOrientation orientation) {
+    UNUSED(vp);
+    UNUSED(orientation);
+}
+
+void view_port_draw_callback_set(ViewPort* vp, ViewPortDrawCallback cb, void* ctx) {
+    UNUSED(vp);
+    UNUSED(cb);
+    UNUSED(ctx);
+}
+
+void view_port_input_callback_set(ViewPort* vp, ViewPortInputCallback cb, void* ctx) {
+    UNUSED(vp);
+    UNUSED(cb);
+    UNUSED(ctx);
+}
+
+void view_port_update(ViewPort* vp) {
+    UNUSED(vp);
+}
+
+void gui_add_view_port(Gui* gui, ViewPort* vp, GuiLayer layer) {
+    UNUSED(gui);
+    UNUSED(vp);
+    UNUSED(layer);
+}
+
+void gui_remove_view_port(Gui* gui, ViewPort* vp) {
+    UNUSED(gui);
+    UNUSED(vp);
+}
+
+// ─── Storage ────────────────────────────────────────────────────────────────
+
+struct File {
+    FILE* fp;
+};
+
+File* storage_file_alloc(Storage* st) {
+    UNUSED(st);
+    return calloc(1, sizeof(File));
+}
+
+void storage_file_free(File* f) {
+    free(f);
+}
+
+bool storage_file_open(File* f, const char* path, FS_AccessMode access, FS_OpenMode mode) {
+    const char* how = "rb";
+    if(access & FSAM_WRITE) {
+        if(mode & (FSOM_CREATE_ALWAYS | FSOM_CREATE_NEW))
+            how = access & FSAM_READ ? "w+b" : "wb";
+        else if(mode & FSOM_OPEN_APPEND)
+            how = "ab";
+        else
+            how = "r+b";
+    }
+    f->fp = fopen(path, how);
+    return f->fp != NULL;
+}
+
+bool storage_file_close(File* f) {
+    bool ok = !f->fp || fclose(f->fp) == 0;
+    f->fp = NULL;
+    return ok;
+}
+
+size_t storage_file_read(File* f, void* buf, size_t size) {
+    return f->fp ? fread(buf, 1, size, f->fp) : 0;
+}
+
+size_t storage_file_write(File* f, const void* buf, size_t size) {
+    return f->fp ? fwrite(buf, 1, size, f->fp) : 0;
+}
+
+bool storage_file_seek(File* f, uint32_t offset, bool from_start) {
+    return f->fp && fseek(f->fp, offset, from_start ? SEEK_SET : SEEK_CUR) == 0;
+}
+
+FS_Error storage_common_rename(Storage* st, const char* from, const char* to) {
+    UNUSED(st);
+    return rename(from, to) == 0 ? FSE_OK : FSE_INTERNAL;
+}
+
+FS_Error storage_common_remove(Storage* st, const char* path) {
+    UNUSED(st);
+    return remove(path) == 0 ? FSE_OK : FSE_NOT_EXIST;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <furi.h>
+#include <input/input.h>
+
+// ─── Canvas ─────────────────────────────────────────────────────────────────
+// A 1bpp frame buffer drawn in software (see canvas_host.c)
+
+typedef struct Canvas Canvas;
+typedef enum { ColorWhite = 0, ColorBlack = 1, ColorXOR = 2 } Color;
+typedef enum { FontPrimary, FontSecondary, FontKeyboard, FontBigNumbers } Font;
+typedef enum { AlignLeft, AlignRight, AlignTop, AlignBottom, AlignCenter } Align;
+
+void canvas_clear(Canvas* c);
+void canvas_set_color(Canvas* c, Color color);
+void canvas_set_font(Canvas* c, Font font);
+void canvas_draw_dot(Canvas* c, int32_t x, int32_t y);
+void canvas_draw_box(Canvas* c, int32_t x, int32_t y, size_t w, size_t h);
+void canvas_draw_frame(Canvas* c, int32_t x, int32_t y, size_t w, size_t h);
+void canvas_draw_rframe(Canvas* c, int32_t x, int32_t y, size_t w, size_t h, size_t r);
+void canvas_draw_str(Canvas* c, int32_t x, int32_t y, const char* str);
+void canvas_draw_str_aligned(Canvas* c, int32_t x, int32_t y, Align h, Align v, const char* str);
+uint16_t canvas_string_width(Canvas* c, const char* str);
+void canvas_draw_xbm(Canvas* c, int32_t x, int32_t y, size_t w, size_t h, const uint8_t* bits);
+
+// Host only: a cleared canvas of the given size
+Canvas* canvas_host_alloc(uint8_t width, uint8_t height);
+void canvas_host_free(Canvas* c);
+
+// ─── View Port ──────────────────────────────────────────────────────────────
+
+typedef struct ViewPort ViewPort;
+typedef enum { ViewPortOrientationHorizontal, ViewPortOrientationVertical } ViewPortOrientation;
+typedef void (*ViewPortDrawCallback)(Canvas* canvas, void* ctx);
+typedef void (*ViewPortInputCallback)(InputEvent* event, void* ctx);
+
+ViewPort* view_port_alloc(void);
+void view_port_free(ViewPort* vp);
+void view_port_set_orientation(ViewPort* vp, ViewPortOrientation orientation);
+void view_port_draw_callback_set(ViewPort* vp, ViewPortDrawCallback cb, void* ctx);
+void view_port_input_callback_set(ViewPort* vp, ViewPortInputCallback cb, void* ctx);
+void view_port_update(ViewPort* vp);
+
+// ─── Gui ────────────────────────────────────────────────────────────────────
+
+#define RECORD_GUI "gui"
+typedef struct Gui Gui;
+typedef enum { GuiLayerFullscreen } GuiLayer;
+
+void gui_add_view_port(Gui* gui, ViewPort* vp, GuiLayer layer);
+void gui_remove_view_port(Gui* gui, ViewPort* vp);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <furi.h>
+
+// Files are host files, opened relative to the working directory
+
+#define RECORD_STORAGE "storage"
+typedef struct Storage Storage;
+typedef struct File File;
+typedef enum { FSAM_READ = 1, FSAM_WRITE = 2 } FS_AccessMode;
+typedef enum {
+    FSOM_OPEN_EXISTING = 1,
+    FSOM_OPEN_ALWAYS = 2,
+    FSOM_OPEN_APPEND = 4,
+    FSOM_CREATE_NEW = 8,
+    FSOM_CREATE_ALWAYS = 16,
+} FS_OpenMode;
+typedef enum { FSE_OK, FSE_NOT_READY, FSE_EXIST, FSE_NOT_EXIST, FSE_INTERNAL } FS_Error;
+
+File* storage_file_alloc(Storage* st);
+void storage_file_free(File* f);
+bool storage_file_open(File* f, const char* path, FS_AccessMode access, FS_OpenMode mode);
+bool storage_file_close(File* f);
+size_t storage_file_read(File* f, void* buf, size_t size);
+size_t storage_file_write(File* f, const void* buf, size_t size);
+bool storage_file_seek(File* f, uint32_t offset, bool from_start);
+FS_Error storage_common_rename(Storage* st, const char* from, const char* to);
+FS_Error storage_common_remove(Storage* st, const char* path);
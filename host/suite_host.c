@@ -0,0 +1,70 @@
+/*
+ * Host build of the scenario suite.
+ * Compiles race_game.c unchanged against the stand-in SDK in sdk/ and runs
+ * the app's own suite_run(), drawing each frame with draw_callback() onto
+ * a software canvas instead of waiting on the GUI. Writes the same
+ * bench.csv as the device and compares it with bench_base.bin in the
+ * working directory; the first run, or the first after deleting it,
+ * becomes the baseline. Exits non-zero when a scenario is slower than the
+ * baseline by more than the slack.
+ *
+ * usage: suite_host [slack_pct]
+ */
+
+#include "../race_game.c"
+
+#define HOST_PASSES 9 // Each scenario's fastest pass counts, to ride out host noise
+
+static RaceArena arena;
+static Canvas* canvas;
+
+// Draws straight onto the software canvas; nothing is ever dropped
+static SuiteFrame host_show(RaceGameState* s, uint32_t* cycles) {
+    draw_callback(canvas, s->render);
+    *cycles = s->render->draw_cycles;
+    return SuiteFrameDrawn;
+}
+
+int main(int argc, char** argv) {
+    int32_t slack = argc > 1 ? strtol(argv[1], NULL, 0) : SUITE_SLACK_PCT;
+
+    RaceGameState* s = &arena.game;
+    s->persist = &arena.persist;
+    s->persist->storage = furi_record_open(RECORD_STORAGE);
+    s->persist->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    s->render = &arena.render;
+    s->render->ready = 1;
+    s->render->front = 2;
+    road_layer_build(s->render->road_layer);
+    s->state = StatePlaying; // Scenarios are drawn as runs
+    canvas = canvas_host_alloc(SCREEN_W, SCREEN_H);
+    suite_run(s, host_show, HOST_PASSES);
+    canvas_host_free(canvas);
+
+    // The device hands this to the persist worker; here it is written in place
+    suite_finish(s);
+    persist_flush(s->persist, PersistSuite);
+
+    const SuiteReport* rep = &s->suite;
+    bool ok = true;
+    printf("scenario  sim avg/max %s  draw avg/max %s  vs base\n", SUITE_UNIT, SUITE_UNIT);
+    for(uint8_t i = 0; i < rep->run.count; i++) {
+        const SuiteTiming* t = &rep->run.t[i];
+        printf(
+            "%-8s  %6lu/%-6lu   %6lu/%-6lu   ",
+            t->name,
+            (unsigned long)t->sim_avg,
+            (unsigned long)t->sim_max,
+            (unsigned long)t->draw_avg,
+            (unsigned long)t->draw_max);
+        if(rep->delta_pct[i] == SUITE_NO_BASE) {
+            printf("new\n");
+        } else {
+            printf("%+ld%%\n", (long)rep->delta_pct[i]);
+            if(rep->delta_pct[i] > slack) ok = false;
+        }
+    }
+    printf("csv: %s%s\n", SUITE_CSV_PATH, rep->new_base ? ", saved as the baseline" : "");
+    if(!ok) printf("FAIL: slower than %s by more than %d%%\n", SUITE_BASE_PATH, slack);
+    return ok ? 0 : 1;
+}
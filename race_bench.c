@@ -0,0 +1,103 @@
+#include "race_bench.h"
+
+#include <string.h>
+
+#define BENCH_LANE_ODDS 20 // One lane change per this many steps on average
+
+static const RaceHal bench_hal = {0};
+
+static uint32_t bench_rng(uint32_t* x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+void race_bench_run(
+    RaceSim* sim,
+    uint32_t steps,
+    uint32_t seed,
+    RaceBenchClock clock,
+    RaceBenchResult* res) {
+    memset(res, 0, sizeof(RaceBenchResult));
+    uint32_t input = seed ? seed : 1;
+    const RaceHal* hal = sim->hal;
+    sim->hal = &bench_hal;
+
+    for(uint32_t i = 0; i < steps; i++) {
+        if(i == 0 || !sim->running) {
+            // Every run gets its own seed so the bench covers many layouts;
+            // one the caller left behind, even a paused one, is never reused
+            race_sim_start(sim, DiffNormal, bench_rng(&input));
+            res->runs++;
+        }
+
+        uint32_t r = bench_rng(&input);
+        uint32_t t0 = clock();
+        if(r % BENCH_LANE_ODDS == 0) race_sim_change_lane(sim, (r >> 8) & 1 ? 1 : -1);
+        race_sim_step(sim);
+        uint32_t dt = clock() - t0;
+
+        res->total_cycles += dt;
+        if(dt > res->worst_cycles) res->worst_cycles = dt;
+        res->steps++;
+    }
+
+    sim->running = false;
+    sim->hal = hal;
+}
+
+// ─── Scenarios ──────────────────────────────────────────────────────────────
+
+#define STAGE_PW(t) (1 << (t))
+
+const RaceBenchScenario race_bench_scenarios[RACE_BENCH_SCENARIOS] = {
+    {.name = "boss", .difficulty = DiffNormal, .level = 5, .boss = true},
+    {.name = "magnet", .difficulty = DiffNormal, .level = 3, .coins = MAX_COINS, .powerups = STAGE_PW(PwMagnet)},
+    {.name = "crash", .difficulty = DiffNormal, .level = 1, .burst_steps = LEGACY_TICK_STEPS},
+    {.name = "dense", .difficulty = DiffHard, .level = 30, .obstacles = MAX_OBS},
+};
+
+void race_bench_scenario_start(RaceSim* sim, const RaceBenchScenario* sc, uint32_t seed) {
+    sim->hal = &bench_hal;
+    race_sim_start(sim, sc->difficulty, seed);
+    race_sim_stage_level(sim, sc->level);
+    sim->stage_boss = sc->boss;
+}
+
+// Top-ups enter at the top of the road, one per step per kind, so they
+// spread out down the screen instead of stacking
+static void scenario_stage(RaceSim* sim, const RaceBenchScenario* sc, uint32_t r) {
+    const EntityPool* p = &sim->ents;
+    if(sim->level != sc->level) race_sim_stage_level(sim, sc->level); // Speed stays put
+    if(p->kind_count[KindObstacle] < sc->obstacles)
+        race_sim_stage_spawn(sim, KindObstacle, r % LANE_COUNT, FX(-18), (r >> 8) % ObsTruck);
+    if(p->kind_count[KindCoin] < sc->coins)
+        race_sim_stage_spawn(sim, KindCoin, (r >> 4) % LANE_COUNT, FX(-12), 0);
+    for(uint8_t t = 0; t < PwCount; t++)
+        if(sc->powerups & STAGE_PW(t)) sim->pw_ticks[t] = MAGNET_STEPS;
+    sim->pw_ticks[PwShield] = SHIELD_STEPS;
+    if(sc->burst_steps && sim->tick_count % sc->burst_steps == 0)
+        race_sim_stage_burst(sim, BurstCrash, SCREEN_W / 2 + (int16_t)(r % 17) - 8, PLAYER_Y - (int16_t)((r >> 12) % 64));
+}
+
+uint32_t race_bench_scenario_steps(
+    RaceSim* sim,
+    const RaceBenchScenario* sc,
+    uint8_t steps,
+    RaceBenchClock clock,
+    uint32_t* worst) {
+    uint32_t total = 0;
+    uint32_t input = sim->tick_count * 2654435761u + 1; // Reproducible per step
+    for(uint8_t i = 0; i < steps && sim->running; i++) {
+        uint32_t r = bench_rng(&input);
+        scenario_stage(sim, sc, r);
+        uint32_t t0 = clock();
+        if(r % BENCH_LANE_ODDS == 0) race_sim_change_lane(sim, (r >> 8) & 1 ? 1 : -1);
+        race_sim_step(sim);
+        uint32_t dt = clock() - t0;
+        total += dt;
+        if(worst && dt > *worst) *worst = dt;
+    }
+    return total;
+}
@@ -0,0 +1,58 @@
+/*
+ * Headless benchmark for the simulation core.
+ * Drives RaceSim with seeded random input and no rendering, timing every
+ * step on a caller-supplied cycle counter. Furi-free like race_core.
+ * Scripted scenarios hold a run at a fixed load instead, so the app can
+ * time its frames, drawing included, against earlier builds.
+ */
+
+#pragma once
+
+#include "race_core.h"
+
+typedef uint32_t (*RaceBenchClock)(void); // Free-running cycle counter
+
+typedef struct {
+    uint32_t steps;
+    uint32_t runs; // Runs started, counting restarts after a game over
+    uint64_t total_cycles;
+    uint32_t worst_cycles; // Slowest single step, input included
+} RaceBenchResult;
+
+// Runs `steps` simulation steps on `sim`, replacing its HAL with a silent one.
+// The first step always starts a fresh run, whatever `sim` held before.
+void race_bench_run(
+    RaceSim* sim,
+    uint32_t steps,
+    uint32_t seed,
+    RaceBenchClock clock,
+    RaceBenchResult* res);
+
+// A run held at one load. Before each step the sim is topped back up to it
+// through the staging hooks, outside the timed part. The shield is always
+// kept up so the run never ends and collisions still take the hit path.
+typedef struct {
+    const char* name; // Stable: the CSV and baseline key
+    Difficulty difficulty;
+    uint16_t level;
+    bool boss; // Every wave is a boss wave
+    uint8_t obstacles; // Kept on the road, at most MAX_OBS
+    uint8_t coins; // Kept on the road, at most MAX_COINS
+    uint8_t powerups; // Timed power-ups kept running, 1 << PowerUpType
+    uint8_t burst_steps; // A crash burst every this many steps, 0 for none
+} RaceBenchScenario;
+
+#define RACE_BENCH_SCENARIOS 4
+extern const RaceBenchScenario race_bench_scenarios[RACE_BENCH_SCENARIOS];
+
+// Starts a staged run on `sim` with a silent HAL; put the app's HAL back after
+void race_bench_scenario_start(RaceSim* sim, const RaceBenchScenario* sc, uint32_t seed);
+
+// Runs `steps` staged steps; returns their cycles and raises *worst, if
+// given, to the slowest one
+uint32_t race_bench_scenario_steps(
+    RaceSim* sim,
+    const RaceBenchScenario* sc,
+    uint8_t steps,
+    RaceBenchClock clock,
+    uint32_t* worst);
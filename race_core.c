@@ -0,0 +1,953 @@
+#include "race_core.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ─── Difficulty Settings ────────────────────────────────────────────────────
+// Up to LEGACY_LEVELS the curve is still tuned as the old per-tick timer
+// periods (ms) and spawn intervals (in ticks); level_velocity() turns it
+// into a velocity. Past it, endless_pressure() keeps rising: it speeds
+// traffic up, tightens the wave spacing and mixes in more boss waves, each
+// approaching a limit so the game stays readable.
+#define LEGACY_LEVELS 9
+#define PRESSURE_MAX 256
+#define PRESSURE_HALF 10 // Levels past the legacy curve to reach half pressure
+#define WAVE_UNITS 4 // Spawn wave gap units per old spawn interval
+
+static const uint16_t diff_speed[] = {140, 120, 90};
+static const uint16_t diff_min_speed[] = {70, 50, 35};
+static const uint8_t diff_spawn[] = {15, 12, 9};
+
+static uint8_t legacy_step_px(uint16_t level) {
+    return 3 + level / 2;
+}
+
+// In 1/VEL_ONE sub-pixels per step, rounded, so the old per-tick pace holds
+static uint16_t level_velocity(Difficulty d, uint16_t level) {
+    int16_t period = diff_speed[d] - level * 8;
+    if(period < diff_min_speed[d]) period = diff_min_speed[d];
+    return ((uint32_t)FX(legacy_step_px(level)) * SIM_STEP_MS * VEL_ONE + period / 2) / period;
+}
+
+// 0 up to LEGACY_LEVELS, then rising towards PRESSURE_MAX
+static uint16_t endless_pressure(uint16_t level) {
+    if(level <= LEGACY_LEVELS) return 0;
+    uint32_t n = level - LEGACY_LEVELS;
+    return PRESSURE_MAX * n / (n + PRESSURE_HALF);
+}
+
+// Speed of each move class relative to the base, in twelfths
+static const uint8_t move_scale[MoveCount] = {
+    [MoveBase] = 12,
+    [MoveFast] = 16, // Motos are faster
+    [MoveSlow] = 8, // Trucks and scenery are slower
+};
+
+// Recomputes everything that follows from the level, once per level up
+static void apply_level(RaceSim* s) {
+    uint16_t level = s->level < LEGACY_LEVELS ? s->level : LEGACY_LEVELS;
+    uint16_t p = endless_pressure(s->level);
+    s->pressure = p;
+
+    // Up to 1.25x the legacy top speed; spacing does the rest
+    uint16_t v = level_velocity(s->difficulty, level) * (4 * PRESSURE_MAX + p) / (4 * PRESSURE_MAX);
+    for(int i = 0; i < MoveCount; i++) s->vel_q[i] = (v * move_scale[i] + 6) / 12;
+
+    // Wave spacing closes in to halfway between the level 0 and legacy top
+    // spacing, which never gets below what race_waves_valid() checks
+    uint16_t top = FX(diff_spawn[s->difficulty] * legacy_step_px(level)) / WAVE_UNITS;
+    uint16_t low = FX(diff_spawn[s->difficulty] * legacy_step_px(0)) / WAVE_UNITS;
+    s->wave_unit = top - (uint32_t)(top - low) * p / (2 * PRESSURE_MAX);
+    s->pw_interval = FX(60 * legacy_step_px(level));
+}
+
+// ─── Platform Shim ──────────────────────────────────────────────────────────
+
+static uint32_t hal_now(RaceSim* s) {
+    return s->hal && s->hal->now_ms ? s->hal->now_ms(s->hal->ctx) : 0;
+}
+
+static uint32_t prof_now(RaceSim* s) {
+    return s->hal && s->hal->cycles ? s->hal->cycles(s->hal->ctx) : 0;
+}
+
+// Charges the cycles since `mark` to a section and returns the new mark
+static uint32_t prof_lap(RaceSim* s, RaceProfSection sec, uint32_t mark) {
+    uint32_t now = prof_now(s);
+    s->prof_cycles[sec] += now - mark;
+    return now;
+}
+
+static void play_sound(RaceSim* s, RaceSound id, int16_t pitch) {
+    if(s->hal && s->hal->sound) s->hal->sound(s->hal->ctx, id, pitch);
+}
+
+static void vibrate(RaceSim* s, RaceHaptic id) {
+    if(s->hal && s->hal->haptic) s->hal->haptic(s->hal->ctx, id);
+}
+
+// ─── Helpers ────────────────────────────────────────────────────────────────
+
+static uint32_t xorshift32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Gameplay randomness lives in the state so a seed replays bit-exactly
+static uint32_t rng_next(RaceSim* s) {
+    return xorshift32(&s->rng);
+}
+
+static int16_t rng_range(RaceSim* s, uint16_t n) {
+    return rng_next(s) % n;
+}
+
+// Effects only: particles draw from their own stream
+static int16_t fx_range(RaceSim* s, uint16_t n) {
+    return xorshift32(&s->particle_rng) % n;
+}
+
+// ─── Entity Pool ────────────────────────────────────────────────────────────
+
+static const uint8_t kind_cap[KindCount] = {MAX_OBS, MAX_COINS, MAX_POWERUPS};
+
+// A hitbox plus its per-lane tables, all constant-folded
+#define HIT_X(x, l) (CAR_LX(l) + (x))
+#define HIT_ON(x, w, l, m) \
+    (((m) < LANE_COUNT && HIT_X(x, l) < LANE_X0(m) + LANE_WIDTH && HIT_X(x, l) + (w) > LANE_X0(m)) << (m))
+#define HIT_COVERS(x, w, l) (HIT_ON(x, w, l, 0) | HIT_ON(x, w, l, 1) | HIT_ON(x, w, l, 2) | HIT_ON(x, w, l, 3))
+#define ENTITY_HIT(x, w, h)                                                 \
+    .hit = {x, w, h}, .hit_x = {HIT_X(x, 0), HIT_X(x, 1), HIT_X(x, 2), HIT_X(x, 3)}, \
+    .covers = {HIT_COVERS(x, w, 0), HIT_COVERS(x, w, 1), HIT_COVERS(x, w, 2), HIT_COVERS(x, w, 3)}
+
+static const EntityDesc obs_desc[ObsCount] = {
+    [ObsMoto] = {ENTITY_HIT(2, 6, 10), .move = MoveFast, .exit_margin = 12, .score = 10, .lanes = 1},
+    [ObsSedan] = {ENTITY_HIT(0, CAR_W, 12), .move = MoveBase, .exit_margin = 12, .score = 10, .lanes = 1},
+    // Centered on the lanes it covers
+    [ObsTruck] = {
+        ENTITY_HIT(TRUCK_DX(TRUCK_HIT_W), TRUCK_HIT_W, 16),
+        .move = MoveSlow,
+        .exit_margin = 16,
+        .score = 10,
+        .lanes = TRUCK_LANES,
+        .pass_burst = BurstBoss,
+    },
+};
+static const EntityDesc pickup_desc = {ENTITY_HIT(0, 8, 8), .move = MoveBase, .lanes = 1};
+
+typedef struct {
+    uint16_t steps; // Effect time, 0 for instant
+    uint8_t lives; // Lives granted
+    uint8_t haptic; // RaceHaptic on pickup, 0 for none
+} PowerUpDesc;
+
+static const PowerUpDesc pw_desc[PwCount] = {
+    [PwShield] = {.steps = SHIELD_STEPS},
+    [PwMagnet] = {.steps = MAGNET_STEPS},
+    [PwFuel] = {.lives = 1, .haptic = HapDoublePulse},
+};
+
+// Adds the slot to every lane bucket its hitbox overlaps. The player's
+// hitbox lies within its own lane, so that one bucket is a complete
+// broadphase for anything that can touch it, two-lane trucks included.
+static void pool_index_lanes(EntityPool* p, uint8_t e) {
+    for(uint8_t m = p->desc[e]->covers[p->lane[e]]; m; m &= m - 1)
+        p->lane_mask[__builtin_ctz(m)] |= 1UL << e;
+}
+
+static void pool_unindex_lanes(EntityPool* p, uint8_t e) {
+    for(int l = 0; l < LANE_COUNT; l++) p->lane_mask[l] &= ~(1UL << e);
+}
+
+static void pool_set_lane(EntityPool* p, uint8_t e, int8_t lane) {
+    pool_unindex_lanes(p, e);
+    p->lane[e] = lane;
+    pool_index_lanes(p, e);
+}
+
+static const EntityDesc* entity_desc(uint8_t kind, uint8_t type) {
+    return kind == KindObstacle ? &obs_desc[type] : &pickup_desc;
+}
+
+static void pool_reset(EntityPool* p) {
+    p->live_count = 0;
+    p->free_count = MAX_ENTITIES;
+    for(uint8_t i = 0; i < MAX_ENTITIES; i++) p->free_slots[i] = MAX_ENTITIES - 1 - i;
+    memset(p->kind_count, 0, sizeof(p->kind_count));
+    memset(p->kind_mask, 0, sizeof(p->kind_mask));
+    memset(p->lane_mask, 0, sizeof(p->lane_mask));
+}
+
+// Returns the new slot, or -1 when the kind is at its cap
+static int8_t pool_spawn(EntityPool* p, EntityKind kind, int8_t lane, int16_t y, uint8_t type) {
+    if(p->kind_count[kind] >= kind_cap[kind]) return -1;
+    uint8_t e = p->free_slots[--p->free_count];
+    p->lane[e] = lane;
+    p->y[e] = y;
+    p->kind[e] = kind;
+    p->type[e] = type;
+    p->desc[e] = entity_desc(kind, type);
+    p->live_pos[e] = p->live_count;
+    p->live[p->live_count++] = e;
+    p->kind_count[kind]++;
+    p->kind_mask[kind] |= 1UL << e;
+    pool_index_lanes(p, e);
+    return e;
+}
+
+// Swap-removes the slot; iterate `live` backwards when despawning in a loop
+static void pool_despawn(EntityPool* p, uint8_t e) {
+    uint8_t last = p->live[--p->live_count];
+    p->live[p->live_pos[e]] = last;
+    p->live_pos[last] = p->live_pos[e];
+    p->free_slots[p->free_count++] = e;
+    p->kind_count[p->kind[e]]--;
+    p->kind_mask[p->kind[e]] &= ~(1UL << e);
+    pool_unindex_lanes(p, e);
+}
+
+// ─── Particles ──────────────────────────────────────────────────────────────
+
+typedef struct {
+    uint8_t count;
+    uint8_t spread; // dx and dy are within +-spread
+    uint8_t life; // Particle updates, plus up to life_rand - 1 more
+    uint8_t life_rand;
+} BurstDesc;
+
+static const BurstDesc burst_desc[BurstCount] = {
+    [BurstCrash] = {.count = 12, .spread = 3, .life = 8, .life_rand = 5},
+    [BurstCoin] = {.count = 4, .spread = 1, .life = 3, .life_rand = 3},
+    [BurstShield] = {.count = 8, .spread = 2, .life = 5, .life_rand = 3},
+    [BurstBoss] = {.count = 6, .spread = 2, .life = 4, .life_rand = 4},
+};
+
+// Appends up to a burst's count; a full pool just makes it smaller
+static void spawn_burst(RaceSim* s, BurstKind kind, int16_t cx, int16_t cy) {
+    const BurstDesc* b = &burst_desc[kind];
+    if(kind == BurstNone || cx < 0 || cx >= SCREEN_W || cy < 0 || cy >= SCREEN_H) return;
+    for(uint8_t i = 0; i < b->count && s->particle_count < MAX_PARTICLES; i++) {
+        Particle* pt = &s->particles[s->particle_count++];
+        pt->x = cx;
+        pt->y = cy;
+        pt->dx = fx_range(s, 2 * b->spread + 1) - b->spread;
+        pt->dy = fx_range(s, 2 * b->spread + 1) - b->spread;
+        pt->life = b->life + fx_range(s, b->life_rand);
+    }
+}
+
+// Expired and off-screen particles are swap-removed, so the renderer gets
+// only drawable ones
+static void update_particles(RaceSim* s) {
+    for(int i = s->particle_count - 1; i >= 0; i--) {
+        Particle* pt = &s->particles[i];
+        pt->x += pt->dx;
+        pt->y += pt->dy;
+        if(--pt->life == 0 || pt->x < 0 || pt->x >= SCREEN_W || pt->y < 0 || pt->y >= SCREEN_H)
+            *pt = s->particles[--s->particle_count];
+    }
+}
+
+// ─── Replay ─────────────────────────────────────────────────────────────────
+
+static void replay_put(Replay* r, uint8_t byte) {
+    if(r->hdr.len >= REPLAY_MAX) {
+        r->full = true;
+        return;
+    }
+    r->events[r->hdr.len++] = byte;
+}
+
+// Logs the lane the player will have from the next step on
+static void replay_record(RaceSim* s) {
+    Replay* r = &s->replay;
+    if(s->playback || r->full) return;
+    uint32_t delta = s->tick_count - r->last_step;
+    while(delta >= REPLAY_SKIP) {
+        replay_put(r, REPLAY_SKIP << 2);
+        delta -= REPLAY_SKIP;
+    }
+    replay_put(r, (delta << 2) | s->player_lane);
+    r->last_step = s->tick_count;
+}
+
+// Decodes the next lane event; returns false at the end of the log
+static bool replay_fetch(Replay* r) {
+    while(r->pos < r->hdr.len) {
+        uint8_t b = r->events[r->pos];
+        r->last_step += b >> 2;
+        if((b >> 2) != REPLAY_SKIP) {
+            r->next_step = r->last_step;
+            return true;
+        }
+        r->pos++;
+    }
+    r->next_step = UINT32_MAX;
+    return false;
+}
+
+// Applies every logged lane change due before the coming step
+static void replay_apply(RaceSim* s) {
+    Replay* r = &s->replay;
+    while(r->next_step == s->tick_count) {
+        s->player_lane = r->events[r->pos++] & (LANE_MAX - 1);
+        replay_fetch(r);
+    }
+}
+
+// ─── Scenery ────────────────────────────────────────────────────────────────
+// Each layer only draws a new cell when it has scrolled a whole one, so a
+// step costs an add and a compare. The far layer is sparser and slower.
+
+static const uint8_t scenery_density[LayerCount] = {2, 3}; // In eighths, per side
+static const uint8_t scenery_speed[LayerCount] = {1, 2}; // In halves of MoveSlow
+
+static uint8_t scenery_cell(RaceSim* s, SceneryLayerId layer) {
+    uint32_t r = xorshift32(&s->scenery_rng);
+    uint8_t density = scenery_density[layer];
+    uint8_t c = (r >> 8 & 0x03) << 4;
+    if((r & 7) < density) c |= 1 + (r >> 3 & 1);
+    if((r >> 4 & 7) < density) c |= (1 + (r >> 7 & 1)) << 2;
+    return c;
+}
+
+static void scenery_push(RaceSim* s, SceneryLayerId layer) {
+    SceneryLayer* l = &s->scenery[layer];
+    l->head = (l->head + 1) & (SCENERY_RING - 1);
+    l->cells[l->head] = scenery_cell(s, layer);
+}
+
+static void init_scenery(RaceSim* s, uint32_t seed) {
+    s->scenery_rng = (seed ^ 0x5CE7E5CEu) | 1;
+    for(int i = 0; i < LayerCount; i++) {
+        s->scenery[i].head = 0;
+        s->scenery[i].scroll = 0;
+        for(int k = 0; k < SCENERY_ROWS; k++) scenery_push(s, i);
+    }
+}
+
+static void update_scenery(RaceSim* s) {
+    for(int i = 0; i < LayerCount; i++) {
+        SceneryLayer* l = &s->scenery[i];
+        l->scroll += s->vel[MoveSlow] * scenery_speed[i] / 2;
+        while(l->scroll >= FX(SCENERY_CELL_H)) {
+            l->scroll -= FX(SCENERY_CELL_H);
+            scenery_push(s, i);
+        }
+    }
+}
+
+// ─── Init ───────────────────────────────────────────────────────────────────
+
+static void wave_next(RaceSim* s); // Spawning
+
+static void sim_reset(RaceSim* s, Difficulty difficulty, uint32_t seed) {
+    s->running = true;
+    s->difficulty = difficulty;
+    s->rng = seed ? seed : 1;
+    s->player_lane = LANE_COUNT / 2;
+    s->score = 0;
+    s->level = 0;
+    s->lives = INITIAL_LIVES;
+    apply_level(s);
+    s->tick_count = 0;
+    s->last_ms = hal_now(s);
+    s->step_acc = 0;
+    s->input_head = 0;
+    s->input_count = 0;
+    s->wave_dist = 0;
+    s->pw_dist = 0;
+    s->road_scroll = 0;
+    s->invincible_ticks = 0;
+    memset(s->pw_ticks, 0, sizeof(s->pw_ticks));
+    memset(s->vel_acc, 0, sizeof(s->vel_acc));
+    s->combo = 0;
+    s->combo_display = 0;
+    s->run_coins = 0;
+    s->stage_boss = false;
+
+    pool_reset(&s->ents);
+    s->particle_count = 0;
+    s->particle_rng = (seed ^ 0xB0A57FA1u) | 1;
+
+    init_scenery(s, seed);
+    wave_next(s);
+}
+
+void race_sim_start(RaceSim* s, Difficulty difficulty, uint32_t seed) {
+    Replay* r = &s->replay;
+    s->playback = false;
+    memset(&r->hdr, 0, sizeof(ReplayHeader));
+    r->hdr.seed = seed;
+    r->hdr.difficulty = difficulty;
+    r->hdr.lanes = LANE_COUNT;
+    r->last_step = 0;
+    r->full = false;
+    sim_reset(s, difficulty, seed);
+}
+
+void race_sim_start_playback(RaceSim* s) {
+    Replay* r = &s->replay;
+    s->playback = true;
+    r->pos = 0;
+    r->last_step = 0;
+    sim_reset(s, r->hdr.difficulty, r->hdr.seed);
+    replay_fetch(r);
+}
+
+bool race_sim_change_lane(RaceSim* s, int8_t dir) {
+    int8_t lane = s->player_lane + dir;
+    if(!s->running || s->playback || lane < 0 || lane >= LANE_COUNT) return false;
+    s->player_lane = lane;
+    replay_record(s);
+    play_sound(s, SndLane, 0);
+    return true;
+}
+
+// ─── Input Buffer ───────────────────────────────────────────────────────────
+// Lane intents wait here with the time they were made and are applied one
+// per step, so quick taps neither bunch into one step nor get dropped.
+// Intents that would run off the road are refused as they come in.
+
+bool race_sim_input(RaceSim* s, int8_t dir) {
+    if(!s->running || s->playback || s->input_count == RACE_INPUT_MAX) return false;
+    int8_t lane = s->player_lane + dir;
+    for(uint8_t i = 0; i < s->input_count; i++)
+        lane += s->inputs[(s->input_head + i) % RACE_INPUT_MAX].dir;
+    if(lane < 0 || lane >= LANE_COUNT) return false;
+    RaceInput* in = &s->inputs[(s->input_head + s->input_count++) % RACE_INPUT_MAX];
+    in->ms = hal_now(s);
+    in->dir = dir;
+    return true;
+}
+
+// Applies the oldest intent if it was made before `until`
+static void apply_input(RaceSim* s, uint32_t until) {
+    if(!s->input_count) return;
+    RaceInput* in = &s->inputs[s->input_head];
+    if((int32_t)(in->ms - until) > 0) return;
+    s->input_head = (s->input_head + 1) % RACE_INPUT_MAX;
+    s->input_count--;
+    race_sim_change_lane(s, in->dir);
+}
+
+// ─── Collision ──────────────────────────────────────────────────────────────
+
+// Returns the obstacle slot the player touches, or -1
+static int8_t check_collision(RaceSim* s) {
+    EntityPool* p = &s->ents;
+    int16_t px = car_lx(s->player_lane);
+    uint32_t m = p->lane_mask[s->player_lane] & p->kind_mask[KindObstacle];
+    while(m) {
+        uint8_t e = __builtin_ctz(m);
+        m &= m - 1;
+        const Hitbox* hb = &p->desc[e]->hit;
+        int16_t ey = FX_PX(p->y[e]); // Where it is drawn
+        if(PLAYER_Y >= ey + hb->h || PLAYER_Y + CAR_H <= ey) continue;
+        int16_t ox = p->desc[e]->hit_x[p->lane[e]];
+        if((px < ox + hb->w) && (px + CAR_W > ox)) return e;
+    }
+    return -1;
+}
+
+// ─── Coin / Power-Up Collection ─────────────────────────────────────────────
+
+static void check_collections(RaceSim* s) {
+    EntityPool* p = &s->ents;
+    int16_t px = car_lx(s->player_lane);
+
+    // Touch: only pickups bucketed in the player's lane can reach it
+    uint32_t m = p->lane_mask[s->player_lane] & ~p->kind_mask[KindObstacle];
+    while(m) {
+        uint8_t e = __builtin_ctz(m);
+        m &= m - 1;
+        const Hitbox* hb = &p->desc[e]->hit;
+        int16_t ey = FX_PX(p->y[e]);
+        if(PLAYER_Y >= ey + hb->h || PLAYER_Y + CAR_H <= ey) continue;
+        int16_t ex = p->desc[e]->hit_x[p->lane[e]];
+        if(px >= ex + hb->w || px + CAR_W <= ex) continue;
+
+        uint8_t kind = p->kind[e];
+        uint8_t type = p->type[e];
+        pool_despawn(p, e);
+
+        if(kind == KindCoin) {
+            spawn_burst(s, BurstCoin, ex + hb->w / 2, ey + hb->h / 2);
+            s->combo++;
+            s->combo_display = COMBO_SHOW_STEPS;
+            s->run_coins++;
+            uint32_t pts = 25 * (s->combo > 1 ? s->combo : 1);
+            s->score += pts;
+            play_sound(s, SndCoin, s->combo * 100);
+            continue;
+        }
+
+        const PowerUpDesc* d = &pw_desc[type];
+        play_sound(s, SndPowerUp, 0);
+        if(d->steps) s->pw_ticks[type] = d->steps;
+        s->lives += d->lives;
+        if(s->lives > MAX_LIVES) s->lives = MAX_LIVES;
+        if(d->haptic) vibrate(s, d->haptic);
+    }
+
+    // Magnet pulls nearby coins toward the player from any lane
+    if(s->pw_ticks[PwMagnet] == 0 || s->tick_count % LEGACY_TICK_STEPS != 0) return;
+    m = p->kind_mask[KindCoin];
+    while(m) {
+        uint8_t e = __builtin_ctz(m);
+        m &= m - 1;
+        int16_t ey = FX_PX(p->y[e]);
+        if(abs(ey - PLAYER_Y) >= 30) continue;
+        p->y[e] += (ey < PLAYER_Y) ? FX(4) : -FX(4);
+        if(p->lane[e] < s->player_lane)
+            pool_set_lane(p, e, p->lane[e] + 1);
+        else if(p->lane[e] > s->player_lane)
+            pool_set_lane(p, e, p->lane[e] - 1);
+    }
+}
+
+// ─── Spawning ───────────────────────────────────────────────────────────────
+// Obstacles and coins come from hand-made waves. Each step waits `gap`
+// wave units of road (a quarter of the old spawn interval, so spacing still
+// scales with difficulty and speed) and then spawns one cell; a gap of 0
+// shares the previous step's row. A wave may be mirrored left to right.
+// race_waves_valid() proves every wave, and any wave following any other,
+// always leaves the player a free lane.
+
+#define W_LANE(c) ((c) & 0x07)
+#define W_TYPE(c) (((c) >> 3) & 0x03)
+#define W_COIN 0x40
+#define W_EMPTY 0x80 // Only spends the gap
+#define W_OBS(type, lane) (((type) << 3) | (lane))
+#define W_C(lane) (W_COIN | (lane))
+
+typedef struct WaveStep { uint8_t gap; uint8_t cell; } WaveStep;
+typedef struct { const WaveStep* steps; uint8_t len; } Wave;
+
+// Every lane count has its own set
+#define S(l) W_OBS(ObsSedan, l)
+#define M(l) W_OBS(ObsMoto, l)
+#define T(l) W_OBS(ObsTruck, l)
+#define WAVE(w) {w, sizeof(w) / sizeof(w[0])}
+#if LANE_COUNT == 2
+static const WaveStep wave_single[] = {{6, S(0)}, {4, W_C(1)}};
+static const WaveStep wave_slalom[] = {{6, S(0)}, {8, S(1)}, {0, W_C(0)}, {8, S(0)}};
+static const WaveStep wave_moto[] = {{12, M(0)}, {0, W_C(1)}};
+static const WaveStep wave_coins[] = {{4, W_C(0)}, {3, W_C(0)}, {3, W_C(1)}, {6, S(0)}};
+static const WaveStep wave_truck[] = {{8, T(0)}, {0, W_C(1)}, {26, W_EMPTY}};
+static const Wave waves[] = {
+    WAVE(wave_single),
+    WAVE(wave_slalom),
+    WAVE(wave_moto),
+    WAVE(wave_coins),
+};
+static const Wave boss_waves[] = {
+    WAVE(wave_truck),
+};
+#elif LANE_COUNT == 3
+static const WaveStep wave_single[] = {{6, S(0)}, {4, W_C(2)}};
+static const WaveStep wave_center[] = {{6, S(1)}, {0, W_C(0)}};
+static const WaveStep wave_pair[] = {{6, S(0)}, {0, S(2)}, {0, W_C(1)}};
+static const WaveStep wave_slalom[] = {{6, S(0)}, {6, S(2)}, {0, W_C(0)}, {6, S(0)}};
+static const WaveStep wave_stair[] = {{6, S(0)}, {0, S(1)}, {8, S(1)}, {0, S(2)}, {0, W_C(0)}};
+static const WaveStep wave_moto[] = {{12, M(1)}, {6, M(0)}, {0, W_C(2)}};
+static const WaveStep wave_moto_pair[] = {{12, M(0)}, {0, M(2)}};
+static const WaveStep wave_coins[] = {{4, W_C(0)}, {3, W_C(1)}, {3, W_C(2)}, {6, S(0)}};
+static const WaveStep wave_gate[] = {{6, S(1)}, {8, S(0)}, {0, S(2)}, {0, W_C(1)}};
+static const WaveStep wave_truck[] = {{8, T(0)}, {0, W_C(2)}, {26, W_EMPTY}};
+static const WaveStep wave_truck_coins[] = {{8, T(1)}, {0, W_C(0)}, {4, W_C(0)}, {26, W_EMPTY}};
+static const Wave waves[] = {
+    WAVE(wave_single),
+    WAVE(wave_center),
+    WAVE(wave_pair),
+    WAVE(wave_slalom),
+    WAVE(wave_stair),
+    WAVE(wave_moto),
+    WAVE(wave_moto_pair),
+    WAVE(wave_coins),
+    WAVE(wave_gate),
+};
+static const Wave boss_waves[] = {
+    WAVE(wave_truck),
+    WAVE(wave_truck_coins),
+};
+#else
+static const WaveStep wave_single[] = {{6, S(0)}, {4, W_C(2)}};
+static const WaveStep wave_pair[] = {{6, S(0)}, {0, S(2)}, {0, W_C(1)}};
+static const WaveStep wave_triple[] = {{6, S(0)}, {0, S(1)}, {0, S(3)}, {0, W_C(2)}};
+static const WaveStep wave_middle[] = {{6, S(1)}, {0, S(2)}, {0, W_C(0)}};
+static const WaveStep wave_slalom[] = {{6, S(0)}, {0, S(1)}, {8, S(2)}, {0, S(3)}, {0, W_C(0)}};
+static const WaveStep wave_moto[] = {{12, M(1)}, {6, M(2)}, {0, W_C(0)}};
+static const WaveStep wave_moto_pair[] = {{12, M(0)}, {0, M(3)}};
+static const WaveStep wave_coins[] = {{4, W_C(0)}, {3, W_C(1)}, {3, W_C(2)}, {3, W_C(3)}, {6, S(0)}};
+static const WaveStep wave_truck[] = {{8, T(0)}, {0, S(3)}, {0, W_C(2)}, {26, W_EMPTY}};
+static const WaveStep wave_truck_coins[] = {{8, T(1)}, {0, W_C(0)}, {4, W_C(0)}, {26, W_EMPTY}};
+static const Wave waves[] = {
+    WAVE(wave_single),
+    WAVE(wave_pair),
+    WAVE(wave_triple),
+    WAVE(wave_middle),
+    WAVE(wave_slalom),
+    WAVE(wave_moto),
+    WAVE(wave_moto_pair),
+    WAVE(wave_coins),
+};
+static const Wave boss_waves[] = {
+    WAVE(wave_truck),
+    WAVE(wave_truck_coins),
+};
+#endif
+#undef S
+#undef M
+#undef T
+#undef WAVE
+#define WAVES_LEN(w) (sizeof(w) / sizeof(w[0]))
+
+static void wave_next(RaceSim* s) {
+    const Wave* w;
+    // Boss trucks on every 5th level, and ever more often in endless play
+    bool boss = s->stage_boss || (s->level > 0 && s->level % 5 == 0 && rng_range(s, 4) == 0);
+    if(!boss && s->pressure) boss = rng_range(s, PRESSURE_MAX * 4) < s->pressure;
+    if(boss)
+        w = &boss_waves[rng_range(s, WAVES_LEN(boss_waves))];
+    else
+        w = &waves[rng_range(s, WAVES_LEN(waves))];
+    s->wave_step = w->steps;
+    s->wave_end = w->steps + w->len;
+    s->wave_mirror = rng_range(s, 2);
+}
+
+static void wave_spawn(RaceSim* s, uint8_t cell) {
+    if(cell & W_EMPTY) return;
+    uint8_t type = W_TYPE(cell);
+    uint8_t lanes = cell & W_COIN ? 1 : obs_desc[type].lanes;
+    int8_t lane = s->wave_mirror ? LANE_COUNT - lanes - W_LANE(cell) : W_LANE(cell);
+    if(cell & W_COIN)
+        pool_spawn(&s->ents, KindCoin, lane, FX(-12), 0);
+    else
+        pool_spawn(&s->ents, KindObstacle, lane, FX(-18), type);
+}
+
+// Called every step: one compare, and a pointer bump when a step is due
+static void wave_advance(RaceSim* s, uint16_t spd) {
+    uint16_t unit = s->wave_unit;
+    s->wave_dist += spd;
+    while(s->wave_dist >= s->wave_step->gap * unit) {
+        s->wave_dist -= s->wave_step->gap * unit;
+        wave_spawn(s, s->wave_step->cell);
+        if(++s->wave_step == s->wave_end) wave_next(s);
+    }
+}
+
+static void spawn_powerup(RaceSim* s) {
+    int8_t lane = rng_range(s, LANE_COUNT);
+    pool_spawn(&s->ents, KindPowerUp, lane, FX(-12), rng_range(s, PwCount));
+}
+
+// ─── Wave Validation ────────────────────────────────────────────────────────
+// Obstacles are checked at the tightest spacing any difficulty produces.
+// Two obstacles are "close" if at any point before the one ahead has passed
+// the player there is no car-sized gap between them, counting the faster
+// one catching up. Close obstacles are blocked as a group, and every group
+// must leave a lane free. Across a wave boundary nothing may be close, so
+// waves can follow each other in any order.
+
+#define WAVE_SPAWN_Y -18
+#define WAVE_MAX_ITEMS 16
+
+typedef struct {
+    float d; // Road travelled when it spawns
+    float k; // Speed relative to the road
+    uint8_t lanes; // Lane mask
+    uint8_t h;
+} WaveItem;
+
+static float wave_unit_min(void) {
+    uint8_t spawn = diff_spawn[0];
+    for(int d = 1; d < DIFF_COUNT; d++)
+        if(diff_spawn[d] < spawn) spawn = diff_spawn[d];
+    return (float)spawn * legacy_step_px(0) / WAVE_UNITS;
+}
+
+static uint8_t wave_items(const Wave* w, float d, WaveItem* out) {
+    float unit = wave_unit_min();
+    uint8_t n = 0;
+    for(uint8_t i = 0; i < w->len; i++) {
+        const WaveStep* st = &w->steps[i];
+        d += st->gap * unit;
+        if(st->cell & (W_EMPTY | W_COIN)) continue;
+        const EntityDesc* desc = &obs_desc[W_TYPE(st->cell)];
+        if(n == WAVE_MAX_ITEMS || W_LANE(st->cell) + desc->lanes > LANE_COUNT) return 0xFF;
+        out[n].d = d;
+        out[n].k = move_scale[desc->move] / 12.0f;
+        out[n].lanes = ((1 << desc->lanes) - 1) << W_LANE(st->cell);
+        out[n].h = desc->hit.h;
+        n++;
+    }
+    return n;
+}
+
+static float wave_len(const Wave* w) {
+    float d = 0;
+    for(uint8_t i = 0; i < w->len; i++) d += w->steps[i].gap * wave_unit_min();
+    return d;
+}
+
+static bool wave_close(const WaveItem* a, const WaveItem* b) {
+    if(b->d < a->d) {
+        const WaveItem* t = a;
+        a = b;
+        b = t;
+    }
+    // a spawned first; track it until it is behind the player
+    float end = a->d + (PLAYER_Y + CAR_H - WAVE_SPAWN_Y) / a->k;
+    if(end <= b->d) return false;
+    float gap0 = (b->d - a->d) * a->k; // a's lead when b spawns
+    float gap1 = (end - a->d) * a->k - (end - b->d) * b->k;
+    float need = b->h + CAR_H;
+    return gap0 < need || gap1 < need;
+}
+
+static bool wave_groups_free(const WaveItem* it, uint8_t n) {
+    uint8_t group[WAVE_MAX_ITEMS];
+    for(uint8_t i = 0; i < n; i++) group[i] = i;
+    // Union close items until nothing changes
+    for(bool merged = true; merged;) {
+        merged = false;
+        for(uint8_t i = 0; i < n; i++)
+            for(uint8_t j = i + 1; j < n; j++)
+                if(group[i] != group[j] && wave_close(&it[i], &it[j])) {
+                    uint8_t from = group[j];
+                    for(uint8_t k = 0; k < n; k++)
+                        if(group[k] == from) group[k] = group[i];
+                    merged = true;
+                }
+    }
+    for(uint8_t g = 0; g < n; g++) {
+        uint8_t blocked = 0;
+        for(uint8_t i = 0; i < n; i++)
+            if(group[i] == g) blocked |= it[i].lanes;
+        if(blocked == (1 << LANE_COUNT) - 1) return false;
+    }
+    return true;
+}
+
+static bool wave_set_valid(const Wave* set, uint8_t count, const Wave* all, uint8_t all_count) {
+    WaveItem a[WAVE_MAX_ITEMS], b[WAVE_MAX_ITEMS];
+    for(uint8_t i = 0; i < count; i++) {
+        uint8_t na = wave_items(&set[i], 0, a);
+        if(set[i].len == 0 || na == 0xFF || !wave_groups_free(a, na)) return false;
+        for(uint8_t j = 0; j < all_count; j++) {
+            uint8_t nb = wave_items(&all[j], wave_len(&set[i]), b);
+            if(nb == 0xFF) return false;
+            for(uint8_t x = 0; x < na; x++)
+                for(uint8_t y = 0; y < nb; y++)
+                    if(wave_close(&a[x], &b[y])) return false;
+        }
+    }
+    return true;
+}
+
+bool race_waves_valid(void) {
+    Wave all[WAVES_LEN(waves) + WAVES_LEN(boss_waves)];
+    memcpy(all, waves, sizeof(waves));
+    memcpy(&all[WAVES_LEN(waves)], boss_waves, sizeof(boss_waves));
+    return wave_set_valid(all, WAVES_LEN(all), all, WAVES_LEN(all));
+}
+
+// ─── Game Tick ───────────────────────────────────────────────────────────────
+
+void race_sim_step(RaceSim* s) {
+    if(!s->running) return;
+    uint32_t mark = prof_now(s);
+    if(s->playback) replay_apply(s);
+
+    // Whole sub-pixels this step; the fraction carries into the next
+    for(int i = 0; i < MoveCount; i++) {
+        s->vel_acc[i] += s->vel_q[i];
+        s->vel[i] = s->vel_acc[i] >> VEL_SHIFT;
+        s->vel_acc[i] &= VEL_ONE - 1;
+    }
+    const uint16_t* vel = s->vel;
+    uint16_t spd = vel[MoveBase];
+
+    s->tick_count++;
+    s->road_scroll += spd;
+    if(s->road_scroll >= FX(DASH_TOTAL)) s->road_scroll -= FX(DASH_TOTAL);
+
+    if(s->invincible_ticks > 0) s->invincible_ticks--;
+    for(int i = 0; i < PwCount; i++)
+        if(s->pw_ticks[i] > 0) s->pw_ticks[i]--;
+    if(s->combo_display > 0) s->combo_display--;
+
+    if(s->particle_count && s->tick_count % LEGACY_TICK_STEPS == 0) update_particles(s);
+
+    update_scenery(s);
+
+    // Move entities
+    EntityPool* p = &s->ents;
+    for(int i = p->live_count - 1; i >= 0; i--) {
+        uint8_t e = p->live[i];
+        const EntityDesc* d = p->desc[e];
+        int16_t y = p->y[e];
+        p->y[e] += vel[d->move];
+        if(d->pass_burst && y < FX(PLAYER_Y + CAR_H) && p->y[e] >= FX(PLAYER_Y + CAR_H)) {
+            int16_t cx = d->hit_x[p->lane[e]] + d->hit.w / 2;
+            spawn_burst(s, d->pass_burst, cx, PLAYER_Y + CAR_H);
+        }
+        if(p->y[e] > FX(SCREEN_H + d->exit_margin)) {
+            s->score += d->score;
+            pool_despawn(p, e);
+        }
+    }
+
+    mark = prof_lap(s, ProfUpdate, mark);
+
+    // Spawn by distance travelled
+    wave_advance(s, spd);
+    s->pw_dist += spd;
+    if(s->pw_dist >= s->pw_interval) {
+        s->pw_dist = 0;
+        spawn_powerup(s);
+    }
+
+    mark = prof_lap(s, ProfSpawn, mark);
+
+    // Collection
+    check_collections(s);
+
+    // Collision (skip if invincible); the shield knocks the obstacle away
+    int8_t hit = s->invincible_ticks == 0 ? check_collision(s) : -1;
+    if(hit >= 0 && s->pw_ticks[PwShield]) {
+        pool_despawn(p, hit);
+        spawn_burst(s, BurstShield, car_lx(s->player_lane) + CAR_W / 2, PLAYER_Y);
+    } else if(hit >= 0) {
+        s->lives--;
+        s->combo = 0; // Reset combo on hit
+        spawn_burst(s, BurstCrash, car_lx(s->player_lane) + CAR_W / 2, PLAYER_Y + CAR_H / 2);
+        vibrate(s, HapPulse);
+        play_sound(s, SndCrash, 0);
+
+        if(s->lives == 0) {
+            prof_lap(s, ProfCollide, mark);
+            s->running = false;
+            replay_record(s); // Marks where the run ended, for ghosts
+            vibrate(s, HapFade);
+            play_sound(s, SndGameOver, 0);
+            if(s->hal && s->hal->game_over) s->hal->game_over(s->hal->ctx, s);
+            return;
+        }
+        s->invincible_ticks = INVINCIBLE_STEPS;
+    }
+    prof_lap(s, ProfCollide, mark);
+
+    // Level up
+    uint32_t nl = s->score / 200;
+    if(nl > UINT16_MAX) nl = UINT16_MAX;
+    if(nl > s->level) {
+        s->level = nl;
+        apply_level(s);
+        play_sound(s, SndLevelUp, 0);
+    }
+}
+
+uint8_t race_sim_frame(RaceSim* s) {
+    uint32_t now = hal_now(s);
+    s->step_acc += now - s->last_ms;
+    s->last_ms = now;
+
+    uint8_t n = 0;
+    while(s->step_acc >= SIM_STEP_MS && s->running) {
+        if(n == SIM_MAX_CATCHUP) {
+            s->step_acc = 0;
+            break;
+        }
+        // The step covers [now - acc, now - acc + SIM_STEP_MS); looking one
+        // step further ahead keeps a tap just before a tick in this frame
+        apply_input(s, now - s->step_acc + 2 * SIM_STEP_MS);
+        race_sim_step(s);
+        s->step_acc -= SIM_STEP_MS;
+        n++;
+    }
+    return n;
+}
+
+// ─── Pause ──────────────────────────────────────────────────────────────────
+// Everything in a RaceSim is plain data except the HAL, the wave cursor and
+// each entity's descriptor, which point into this build's tables. Pausing
+// notes the cursor as indices (waves, then boss_waves); resuming checks
+// the block and rebuilds all three from the indices and kind/type.
+
+#define WAVE_IDS (WAVES_LEN(waves) + WAVES_LEN(boss_waves))
+
+static const Wave* wave_by_id(uint8_t id) {
+    return id < WAVES_LEN(waves) ? &waves[id] : &boss_waves[id - WAVES_LEN(waves)];
+}
+
+void race_sim_pause(RaceSim* s) {
+    for(uint8_t i = 0; i < WAVE_IDS; i++) {
+        const Wave* w = wave_by_id(i);
+        if(s->wave_end != w->steps + w->len) continue;
+        s->wave_id = i;
+        s->wave_pos = s->wave_step - w->steps;
+        break;
+    }
+    s->input_count = 0; // Taps from before the pause are stale
+}
+
+// Every live slot must be a valid entity on the road
+static bool pool_valid(const EntityPool* p) {
+    static const uint8_t type_count[KindCount] = {ObsCount, 1, PwCount};
+    if(p->live_count > MAX_ENTITIES || p->live_count + p->free_count != MAX_ENTITIES) return false;
+    for(uint8_t i = 0; i < p->free_count; i++)
+        if(p->free_slots[i] >= MAX_ENTITIES) return false;
+    for(uint8_t i = 0; i < p->live_count; i++) {
+        uint8_t e = p->live[i];
+        if(e >= MAX_ENTITIES || p->live_pos[e] != i || p->kind[e] >= KindCount) return false;
+        if(p->type[e] >= type_count[p->kind[e]]) return false;
+        uint8_t lanes = p->kind[e] == KindObstacle ? obs_desc[p->type[e]].lanes : 1;
+        if(p->lane[e] < 0 || p->lane[e] + lanes > LANE_COUNT) return false;
+    }
+    return true;
+}
+
+bool race_sim_resume(RaceSim* s, const RaceHal* hal) {
+    if(!s->running || s->wave_id >= WAVE_IDS || s->player_lane < 0 || s->player_lane >= LANE_COUNT)
+        return false;
+    const Wave* w = wave_by_id(s->wave_id);
+    EntityPool* p = &s->ents;
+    if(s->wave_pos >= w->len || s->particle_count > MAX_PARTICLES || !pool_valid(p)) return false;
+    for(uint8_t i = 0; i < p->live_count; i++) {
+        uint8_t e = p->live[i];
+        p->desc[e] = entity_desc(p->kind[e], p->type[e]);
+    }
+    s->hal = hal;
+    s->wave_step = w->steps + s->wave_pos;
+    s->wave_end = w->steps + w->len;
+    s->input_head = 0;
+    s->input_count = 0;
+    s->last_ms = hal_now(s);
+    return true;
+}
+
+// ─── Staging ────────────────────────────────────────────────────────────────
+
+void race_sim_stage_level(RaceSim* s, uint16_t level) {
+    s->level = level;
+    s->score = (uint32_t)level * 200;
+    apply_level(s);
+}
+
+bool race_sim_stage_spawn(RaceSim* s, EntityKind kind, int8_t lane, int16_t y, uint8_t type) {
+    if(kind == KindObstacle && type >= ObsCount) return false;
+    uint8_t lanes = kind == KindObstacle ? obs_desc[type].lanes : 1;
+    if(lane < 0 || lane + lanes > LANE_COUNT) return false;
+    return pool_spawn(&s->ents, kind, lane, y, type) >= 0;
+}
+
+void race_sim_stage_burst(RaceSim* s, BurstKind kind, int16_t x, int16_t y) {
+    spawn_burst(s, kind, x, y);
+}
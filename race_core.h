@@ -0,0 +1,279 @@
+/*
+ * Race Game simulation core.
+ * Plain C with no Furi dependencies: the app and the benchmark drive it
+ * through RaceHal, so the same code runs on the device and off it.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ─── Layout ─────────────────────────────────────────────────────────────────
+#define SCREEN_W 64
+#define SCREEN_H 128
+// The lane count is a build option: set RACE_LANES in application.fam's
+// cdefines. Each count gets a road wide enough for a car per lane.
+#ifndef RACE_LANES
+#define RACE_LANES 3
+#endif
+#if RACE_LANES == 2
+#define ROAD_LEFT   14
+#define ROAD_RIGHT  49
+#elif RACE_LANES == 3
+#define ROAD_LEFT   10
+#define ROAD_RIGHT  53
+#elif RACE_LANES == 4
+#define ROAD_LEFT   8
+#define ROAD_RIGHT  55
+#else
+#error "RACE_LANES must be 2, 3 or 4"
+#endif
+#define ROAD_WIDTH  (ROAD_RIGHT - ROAD_LEFT)
+#define LANE_COUNT  RACE_LANES
+#define LANE_MAX    4 // Replay events keep the lane in two bits
+#define LANE_WIDTH  (ROAD_WIDTH / LANE_COUNT)
+#define LANE_X0(l)  (ROAD_LEFT + (l) * LANE_WIDTH)
+#define CAR_W 10
+#define CAR_LX(l) (LANE_X0(l) + LANE_WIDTH / 2 - CAR_W / 2) // Car's left edge, centred in the lane
+// Trucks cover two lanes, or one on a 2-lane road so it stays passable
+#define TRUCK_LANES (LANE_COUNT > 2 ? 2 : 1)
+#define TRUCK_SPAN (TRUCK_LANES * LANE_WIDTH)
+#define TRUCK_HIT_W (TRUCK_SPAN - 2 < 20 ? TRUCK_SPAN - 2 : 20)
+#define TRUCK_DX(w) (TRUCK_SPAN / 2 - (w) / 2 - (LANE_WIDTH / 2 - CAR_W / 2)) // From CAR_LX()
+#define CAR_H 13
+#define PLAYER_Y 105
+#define MAX_OBS 5
+#define MAX_COINS 3
+#define MAX_POWERUPS 2
+#define MAX_ENTITIES (MAX_OBS + MAX_COINS + MAX_POWERUPS)
+#define SCENERY_CELL_H 8 // Rows of road per roadside cell
+#define SCENERY_RING 32 // Cells kept per layer, a power of two
+#define SCENERY_ROWS (SCREEN_H / SCENERY_CELL_H + 1) // Cells that can be on screen
+#define MAX_PARTICLES 24
+#define INITIAL_LIVES 3
+#define MAX_LIVES 5
+#define DASH_LEN 8
+#define DASH_GAP 8
+#define DASH_TOTAL (DASH_LEN + DASH_GAP)
+#define REPLAY_MAX 1024
+#define RACE_INPUT_MAX 4 // Lane intents buffered ahead of the steps
+
+// ─── Timing ─────────────────────────────────────────────────────────────────
+// Each frame runs however many fixed simulation steps have accumulated.
+// Positions are 12.4 fixed point and speeds are sub-pixels per step; only
+// the renderer rounds to whole pixels.
+#define SIM_STEP_MS 16
+#define SIM_MAX_CATCHUP 8 // Steps run at most per frame after a stall
+#define MS_TO_STEPS(ms) ((ms) / SIM_STEP_MS)
+#define FX_SHIFT 4
+#define SUBPX (1 << FX_SHIFT)
+#define FX(px) ((px) * SUBPX)
+#define FX_PX(v) (((v) + SUBPX / 2) >> FX_SHIFT) // Rounded to the nearest pixel
+#define VEL_SHIFT 8 // Velocities keep this many bits below a sub-pixel
+#define VEL_ONE (1 << VEL_SHIFT)
+#define LEGACY_TICK_STEPS 6 // Cadence of particle and magnet updates (~96 ms)
+#define INVINCIBLE_STEPS MS_TO_STEPS(2000)
+#define SHIELD_STEPS MS_TO_STEPS(5000)
+#define MAGNET_STEPS MS_TO_STEPS(6000)
+#define COMBO_SHOW_STEPS MS_TO_STEPS(1500)
+
+// ─── Types ──────────────────────────────────────────────────────────────────
+
+typedef enum { ObsMoto, ObsSedan, ObsTruck, ObsCount } ObsType; // 0=narrow/fast, 1=normal, 2=boss(2 lanes)
+typedef enum { PwShield, PwMagnet, PwFuel, PwCount } PowerUpType;
+typedef enum { DiffEasy, DiffNormal, DiffHard } Difficulty;
+typedef enum { MoveBase, MoveFast, MoveSlow, MoveCount } MoveClass;
+#define DIFF_COUNT 3
+
+// A replay is the run's seed plus its lane changes. Each event byte is
+// (steps since the previous event << 2) | new lane; a delta of
+// REPLAY_SKIP only advances time, so idle stretches cost one byte per ~1 s.
+#define REPLAY_SKIP 63
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t len; // Event bytes following the header
+    uint32_t seed;
+    uint8_t difficulty;
+    uint8_t lanes; // LANE_COUNT it was recorded with
+    uint8_t reserved[2];
+    uint32_t crc; // Of the event bytes
+} ReplayHeader;
+
+typedef struct {
+    ReplayHeader hdr;
+    uint8_t events[REPLAY_MAX];
+    uint16_t pos; // Playback read position
+    uint32_t last_step; // Step of the previous event (record and playback)
+    uint32_t next_step; // Playback: step of the pending event
+    bool full;
+} Replay;
+
+typedef enum { KindObstacle, KindCoin, KindPowerUp, KindCount } EntityKind;
+
+typedef struct { int8_t x; uint8_t w; uint8_t h; } Hitbox; // x is relative to car_lx()
+
+typedef enum { BurstNone, BurstCrash, BurstCoin, BurstShield, BurstBoss, BurstCount } BurstKind;
+
+// Per-type constants, kept in flash and indexed by the hot loops instead of
+// branching on the type. Sprites are drawn at car_lx() of the entity's lane.
+typedef struct {
+    Hitbox hit;
+    int8_t hit_x[LANE_MAX]; // Screen x of the hitbox in each lane
+    uint8_t covers[LANE_MAX]; // Mask of lanes the hitbox overlaps, per lane
+    uint8_t move; // MoveClass
+    uint8_t exit_margin; // Rows below the screen before it despawns
+    uint8_t score; // Points for getting past it
+    uint8_t lanes; // Lanes covered, starting at its own
+    uint8_t pass_burst; // BurstKind once it is behind the player
+} EntityDesc;
+
+// Obstacles, coins and power-ups share one structure-of-arrays pool. Live
+// slots are kept densely in `live` so loops never touch dead slots, and
+// spawn/despawn are O(1) through the free stack and swap-remove.
+typedef struct {
+    int8_t lane[MAX_ENTITIES];
+    int16_t y[MAX_ENTITIES]; // Fixed point
+    uint8_t kind[MAX_ENTITIES]; // EntityKind
+    uint8_t type[MAX_ENTITIES]; // ObsType or PowerUpType
+    const EntityDesc* desc[MAX_ENTITIES];
+    uint8_t live[MAX_ENTITIES];
+    uint8_t live_pos[MAX_ENTITIES]; // Slot -> index in live
+    uint8_t live_count;
+    uint8_t free_slots[MAX_ENTITIES];
+    uint8_t free_count;
+    uint8_t kind_count[KindCount];
+    uint32_t kind_mask[KindCount]; // Live slots per kind
+    uint32_t lane_mask[LANE_COUNT]; // Live slots whose hitbox overlaps each lane
+} EntityPool;
+
+typedef struct { int8_t lane; int16_t y; uint8_t type; } EntityView; // y is fixed point
+_Static_assert(MAX_ENTITIES <= 32, "entity masks are 32-bit");
+
+// Roadside scenery is a stream of cells per layer, generated as the road
+// scrolls. A cell holds an optional sprite for each side (0 or type + 1)
+// and a small downward jitter; row k of the window is cells[head - k].
+typedef enum { LayerFar, LayerNear, LayerCount } SceneryLayerId;
+#define SCENERY_LEFT(c) ((c) & 0x03)
+#define SCENERY_RIGHT(c) (((c) >> 2) & 0x03)
+#define SCENERY_DY(c) ((c) >> 4)
+typedef struct {
+    uint8_t cells[SCENERY_RING];
+    uint8_t head; // Newest cell, at the top of the screen
+    int16_t scroll; // Fixed point, within one cell
+} SceneryLayer;
+typedef struct { int16_t x; int16_t y; int8_t dx; int8_t dy; uint8_t life; } Particle; // On screen, life > 0
+typedef struct { uint32_t ms; int8_t dir; } RaceInput; // A lane intent; ms is on the HAL clock
+
+// ─── Platform Shim ──────────────────────────────────────────────────────────
+// Everything the simulation needs from the outside world. Any callback may
+// be NULL; a NULL clock reads as 0 ms.
+
+typedef enum { SndLane, SndCoin, SndPowerUp, SndCrash, SndGameOver, SndLevelUp, SndCount } RaceSound;
+typedef enum { HapPulse = 1, HapDoublePulse, HapFade, HapCount } RaceHaptic;
+typedef enum { ProfUpdate, ProfCollide, ProfSpawn, ProfCoreCount } RaceProfSection;
+
+struct RaceSim;
+
+typedef struct {
+    uint32_t (*now_ms)(void* ctx);
+    uint32_t (*cycles)(void* ctx); // Set to time each step's sections
+    void (*sound)(void* ctx, RaceSound id, int16_t pitch); // pitch is added to every note
+    void (*haptic)(void* ctx, RaceHaptic id);
+    void (*game_over)(void* ctx, const struct RaceSim* sim); // Store the run here
+    void* ctx;
+} RaceHal;
+
+typedef struct RaceSim {
+    const RaceHal* hal;
+    bool running; // Cleared on game over
+    bool playback; // Lanes come from `replay` instead of input
+    Difficulty difficulty;
+    int8_t player_lane;
+    uint32_t score;
+    uint16_t level; // Unbounded; the curve flattens out instead
+    uint8_t lives;
+    uint16_t pressure; // Endless difficulty past the legacy levels, 0..256
+    uint16_t vel_q[MoveCount]; // Per move class, in 1/VEL_ONE sub-pixels per step
+    uint16_t vel_acc[MoveCount]; // Carried fraction, below VEL_ONE
+    uint16_t vel[MoveCount]; // Whole sub-pixels moved this step
+    uint32_t tick_count;
+    uint32_t last_ms;
+    uint32_t step_acc;
+    RaceInput inputs[RACE_INPUT_MAX]; // Ring of pending lane intents
+    uint8_t input_head;
+    uint8_t input_count;
+    int16_t road_scroll; // Fixed point, within one dash period
+    const struct WaveStep* wave_step; // Next step of the current wave
+    const struct WaveStep* wave_end;
+    uint8_t wave_id; // wave_step as indices, kept by race_sim_pause so a
+    uint8_t wave_pos; // paused run can be stored as one flat block
+    bool wave_mirror;
+    bool stage_boss; // Every wave is a boss wave; staging only
+    uint16_t wave_dist; // Sub-pixels travelled since the last wave step
+    uint16_t wave_unit; // Sub-pixels per wave gap unit at this level
+    uint16_t pw_dist; // Sub-pixels travelled since the last power-up
+    uint16_t pw_interval;
+    uint16_t invincible_ticks;
+    uint16_t pw_ticks[PwCount]; // Time left on each timed power-up
+    uint8_t combo;
+    uint16_t combo_display; // ticks to show combo text
+    uint16_t run_coins;
+    uint32_t rng; // xorshift32 state, seeded per run
+    uint32_t scenery_rng; // Separate so scenery never shifts gameplay
+    uint32_t particle_rng; // Likewise, so pickups and hits only the live run made don't
+    Replay replay;
+    EntityPool ents;
+    SceneryLayer scenery[LayerCount];
+    Particle particles[MAX_PARTICLES]; // Live ones first, densely packed
+    uint8_t particle_count;
+    uint32_t prof_cycles[ProfCoreCount]; // Summed per section while hal->cycles is set
+} RaceSim;
+
+// ─── API ────────────────────────────────────────────────────────────────────
+
+// Lane positions are folded at compile time; entries past LANE_COUNT are unused
+#define LANE_TABLE(f) {f(0), f(1), f(2), f(3)}
+static const int8_t lane_lx[LANE_MAX] = LANE_TABLE(CAR_LX);
+_Static_assert(LANE_COUNT <= LANE_MAX, "lane tables hold LANE_MAX lanes");
+
+static inline int16_t car_lx(int8_t lane) {
+    return lane_lx[lane];
+}
+
+// Starts a fresh run and begins recording its replay
+void race_sim_start(RaceSim* s, Difficulty difficulty, uint32_t seed);
+
+// Re-runs the run recorded in s->replay from its seed and lane log
+void race_sim_start_playback(RaceSim* s);
+
+// Returns true when the lane actually changed
+bool race_sim_change_lane(RaceSim* s, int8_t dir);
+
+// Buffers a lane change for the step it falls in; false if it is refused
+bool race_sim_input(RaceSim* s, int8_t dir);
+
+// Freezes the run between frames; the whole RaceSim may then be copied out
+void race_sim_pause(RaceSim* s);
+
+// Picks a paused run back up, also one read back from storage. Re-attaches
+// `hal` and restarts the clock; false when the block is not a usable run.
+bool race_sim_resume(RaceSim* s, const RaceHal* hal);
+
+// Runs one fixed simulation step
+void race_sim_step(RaceSim* s);
+
+// Runs the steps that have accrued on the HAL clock; returns how many ran
+uint8_t race_sim_frame(RaceSim* s);
+
+// Staging: puts a run into states normal play only reaches by chance, for
+// the scenario bench. Entities and bursts are subject to the usual caps.
+void race_sim_stage_level(RaceSim* s, uint16_t level); // Score follows
+bool race_sim_stage_spawn(RaceSim* s, EntityKind kind, int8_t lane, int16_t y, uint8_t type);
+void race_sim_stage_burst(RaceSim* s, BurstKind kind, int16_t x, int16_t y);
+
+// Checks the built-in spawn waves can always be survived; for debug builds
+bool race_waves_valid(void);
@@ -2,9 +2,13 @@
  * Race Game v4.0 for Flipper Zero
  * Features: Multiple obstacles, power-ups, combo, boss truck,
  *           crash particles, difficulty, night mode, high score.
+ *
+ * The simulation lives in race_core.c; this file is the Furi app around it:
+ * input, timing, rendering, sound, vibration and storage.
  */
 
 #include <furi.h>
+#include <furi_hal_cortex.h>
 #include <furi_hal_speaker.h>
 #include <furi_hal_vibro.h>
 #include <gui/gui.h>
@@ -13,429 +17,1130 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "race_bench.h"
+#include "race_core.h"
+#include "race_sprites.h"
+
 // ─── Layout ─────────────────────────────────────────────────────────────────
-#define SCREEN_W 64
-#define SCREEN_H 128
-#define ROAD_LEFT   10
-#define ROAD_RIGHT  53
-#define ROAD_WIDTH  (ROAD_RIGHT - ROAD_LEFT)
-#define LANE_COUNT  3
-#define LANE_WIDTH  (ROAD_WIDTH / LANE_COUNT)
-#define CAR_W 10
-#define CAR_H 13
-#define PLAYER_Y 105
-#define MAX_OBS 5
-#define MAX_COINS 3
-#define MAX_POWERUPS 2
-#define MAX_SCENERY 6
-#define MAX_PARTICLES 12
-#define INITIAL_LIVES 3
-#define MAX_LIVES 5
-#define DASH_LEN 8
-#define DASH_GAP 8
-#define DASH_TOTAL (DASH_LEN + DASH_GAP)
-#define HIGHSCORE_PATH APP_DATA_PATH("highscore.dat")
+// Road edges and dividers, pre-rendered one dash period taller than the screen
+#define ROAD_LAYER_X (ROAD_LEFT - 1)
+#define ROAD_LAYER_W (ROAD_RIGHT + 2 - ROAD_LAYER_X)
+#define ROAD_LAYER_H (SCREEN_H + DASH_TOTAL)
+#define ROAD_LAYER_STRIDE ((ROAD_LAYER_W + 7) / 8)
+#define HIGHSCORE_PATH APP_DATA_PATH("highscore.dat") // Legacy raw uint32_t
+#define SAVE_PATH APP_DATA_PATH("save.bin")
+#define SAVE_TMP_PATH APP_DATA_PATH("save.tmp")
+#define SAVE_MAGIC 0x31474352 // "RCG1"
+#define SAVE_VERSION 1
+#define TOP_N 5
+#define RANK_NONE 0xFF
+#define REPLAY_PATH APP_DATA_PATH("last.rpl")
+#define REPLAY_TMP_PATH APP_DATA_PATH("last.tmp")
+#define GHOST_CHUNK 64 // Replay bytes per ghost stream buffer
+#define REPLAY_MAGIC 0x31504C52 // "RLP1"
+#define REPLAY_VERSION 3 // Bumped whenever a seed plays out differently
+#define SUSPEND_PATH APP_DATA_PATH("suspend.bin") // A paused run kept across an exit
+#define SUSPEND_TMP_PATH APP_DATA_PATH("suspend.tmp")
+#define SUSPEND_MAGIC 0x31535052 // "RPS1"
+#define SUSPEND_VERSION 2
+#define SUITE_CSV_PATH APP_DATA_PATH("bench.csv") // Last suite run, for tooling
+#define SUITE_TMP_PATH APP_DATA_PATH("bench.tmp")
+#define SUITE_BASE_PATH APP_DATA_PATH("bench_base.bin") // Delete to re-baseline
+#define SUITE_MAGIC 0x31535242 // "BRS1"
+#define SUITE_VERSION 2
+
+// ─── Timing ─────────────────────────────────────────────────────────────────
+// The timer runs at a fixed frame rate; race_sim_frame() catches the
+// simulation up in fixed steps.
+#define FRAME_MS 32
+#define DRAW_STALE_MS 250 // A request the GUI never drew is given up after this
+#define BENCH_STEPS 20000 // ~5.5 min of game time
+#define SUITE_FRAMES 240 // Per scenario, ~8 s of game time
+#define SUITE_STEPS (FRAME_MS / SIM_STEP_MS) // Sim steps per suite frame
+#define SUITE_SEED 0x5EED
+#define SUITE_SLACK_PCT 10 // Frames slower than the baseline by more are flagged
+#define SUITE_NO_BASE INT32_MIN // No baseline entry for the scenario
+#ifdef SUITE_NS // Host builds draw far faster, so they keep nanoseconds
+#define SUITE_UNIT "ns"
+#define SUITE_PER_US 1000
+#else
+#define SUITE_UNIT "us"
+#define SUITE_PER_US 1
+#endif
+#define PROF_WINDOW 32 // Samples behind each published min/avg/max
+
+// ─── Memory ─────────────────────────────────────────────────────────────────
+// Thread stacks and the byte budget of each part of the arena (see Arena)
+#define MAIN_STACK (4 * 1024) // stack_size in application.fam
+#define PERSIST_STACK 1024
+#define SOUND_STACK 1024
+#define HAPTIC_STACK 512
+#define GAME_BUDGET 2560
+#define RENDER_BUDGET 4096
+#define PERSIST_BUDGET 2560
+#define SOUND_BUDGET 64
+#define HAPTIC_BUDGET 64
 
 // ─── Types ──────────────────────────────────────────────────────────────────
 
-typedef enum { StateMenu, StatePlaying, StateGameOver } GameState;
-typedef enum { ObsMoto, ObsSedan, ObsTruck } ObsType; // 0=narrow/fast, 1=normal, 2=boss(2 lanes)
-typedef enum { PwShield, PwMagnet, PwFuel } PowerUpType;
-typedef enum { DiffEasy, DiffNormal, DiffHard } Difficulty;
+typedef enum {
+    StateMenu,
+    StatePlaying,
+    StatePaused,
+    StateGameOver,
+    StateBench,
+    StateSuite,
+    StateMemory,
+} GameState;
+typedef enum { MenuStart, MenuSound, MenuNight, MenuSlide, MenuDiff, MenuReplay, MenuGhost, MenuCount } MenuItem;
+
+#define SAVE_FLAG_SOUND (1 << 0)
+#define SAVE_FLAG_NIGHT (1 << 1)
+#define SAVE_FLAG_SLIDE (1 << 2)
+
+// On-disk save record, read and written in one piece. `crc` covers every
+// byte before it.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint8_t difficulty;
+    uint8_t flags; // SAVE_FLAG_*
+    uint16_t reserved;
+    uint32_t top[DIFF_COUNT][TOP_N]; // Descending
+    uint32_t runs;
+    uint32_t coins;
+    uint32_t crc;
+} SaveRecord;
+
+_Static_assert(sizeof(SaveRecord) == 84, "SaveRecord layout is part of the file format");
+
+// Precedes a paused RaceSim stored as-is. The block is only valid for the
+// build that wrote it, so `size` and `lanes` guard against other builds.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size; // sizeof(RaceSim)
+    uint8_t lanes;
+    uint8_t reserved[3];
+    uint32_t crc; // Of the RaceSim block
+} SuspendHeader;
+
+typedef enum { ProfDrawRoad, ProfDrawSprites, ProfDrawHud, ProfDrawCount } ProfDrawSection;
+
+// Section timings are gathered in windows of PROF_WINDOW samples; `out`
+// holds the last finished window.
+typedef struct { uint16_t min; uint16_t avg; uint16_t max; } ProfView; // Microseconds
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;
+    uint8_t n;
+    ProfView out;
+} ProfStat;
+
+// Bench results as shown on screen
+typedef struct {
+    uint32_t steps_per_sec;
+    uint32_t avg_ns;
+    uint32_t worst_us;
+    uint32_t runs;
+    int32_t heap_delta; // Bytes of heap lost across the run; the core allocates nothing
+} BenchReport;
+
+// One scenario of the suite, in SUITE_UNIT per frame of SUITE_STEPS steps and a draw
+typedef struct {
+    char name[8]; // RaceBenchScenario name, the baseline key
+    uint32_t sim_avg;
+    uint32_t sim_max;
+    uint32_t draw_avg;
+    uint32_t draw_max;
+} SuiteTiming;
+
+// The baseline file, read and written in one piece. `crc` covers every
+// byte before it.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t count;
+    uint8_t lanes; // Timings only compare on the same lane count
+    SuiteTiming t[RACE_BENCH_SCENARIOS];
+    uint32_t crc;
+} SuiteRecord;
+
+// Suite results as shown on screen
+typedef struct {
+    SuiteRecord run;
+    int32_t delta_pct[RACE_BENCH_SCENARIOS]; // Frame time against the baseline, or SUITE_NO_BASE
+    bool new_base; // This run became the baseline
+    uint16_t dropped; // Frames the GUI never drew
+} SuiteReport;
+
+typedef enum { MemGame, MemRender, MemPersist, MemSound, MemHaptic, MemPartCount } MemPart;
+typedef enum { ThreadMain, ThreadPersist, ThreadSound, ThreadHaptic, ThreadCount } AppThread;
 
-typedef struct { int8_t lane; int16_t y; bool alive; ObsType type; } Obstacle;
-typedef struct { int8_t lane; int16_t y; bool alive; } Coin;
-typedef struct { int8_t lane; int16_t y; bool alive; PowerUpType type; } PowerUp;
-typedef struct { int16_t y; int8_t side; int8_t type; } Scenery;
-typedef struct { int16_t x; int16_t y; int8_t dx; int8_t dy; uint8_t life; } Particle;
+// Memory report as shown on screen; part sizes are compile-time constants
+typedef struct {
+    uint32_t heap_free;
+    uint32_t heap_min_free; // Lowest since boot
+    uint32_t stack_free[ThreadCount]; // Least free stack each thread has had
+} MemReport;
 
 typedef struct {
+    SuspendHeader suspend_hdr; // Stored right in front of `sim`, see suspend_save()
+    RaceSim sim;
     GameState state;
-    int8_t player_lane;
-    uint32_t score;
+    RaceHal hal;
     uint32_t high_score;
-    uint8_t level;
-    uint8_t lives;
-    uint16_t speed;
-    uint32_t tick_count;
-    int8_t road_scroll;
     bool night_mode;
     bool sound_on;
+    bool slide; // Holding Left/Right slides to the edge of the road
     int8_t menu_idx;
-    Difficulty difficulty;
-    uint8_t invincible_ticks;
-    uint8_t shield_ticks;
-    uint8_t magnet_ticks;
-    uint8_t combo;
-    uint8_t combo_display; // ticks to show combo text
-    Obstacle obstacles[MAX_OBS];
-    Coin coins[MAX_COINS];
-    PowerUp powerups[MAX_POWERUPS];
-    Scenery scenery[MAX_SCENERY];
-    Particle particles[MAX_PARTICLES];
+    Difficulty difficulty; // Menu selection; a replay runs at its own
+    uint8_t rank; // Leaderboard place of the finished run, or RANK_NONE
+    bool back_held; // The Back press that paused, or stopped the suite, is still down
+    bool tool_key; // Left is down in the menu; Up/Down then open a hidden tool
+    bool tool_long; // ...and has been held long
+    bool tool_used; // ...and has opened a tool
+    bool suspend; // Store the paused run on exit
+    SaveRecord save;
+    BenchReport bench;
+    MemReport mem;
+    SuiteReport suite;
+    bool profiler;
+    ProfStat sim_prof[ProfCoreCount]; // Cycles per frame, all steps summed
+    uint32_t missed_ticks; // Timer ticks folded into a later frame
+    uint32_t pending_ticks; // Set by the timer, taken by the loop, accessed atomically
+    FuriThreadId loop_thread;
+    FuriMessageQueue* input_queue; // InputEvent
     FuriTimer* timer;
+    ViewPort* view_port; // The suite redraws from outside the main loop
+    struct SoundEngine* sound;
+    struct HapticEngine* haptics;
+    struct RenderExchange* render;
+    struct Persist* persist;
+    struct Ghost* ghost; // Set while racing a ghost
+    uint32_t frame_gen; // Bumped whenever something visible changes
 } RaceGameState;
 
-typedef enum { EventTypeTick, EventTypeKey } EventType;
-typedef struct { EventType type; InputEvent input; } GameEvent;
+_Static_assert(
+    offsetof(RaceGameState, sim) == offsetof(RaceGameState, suspend_hdr) + sizeof(SuspendHeader),
+    "a suspended run is stored as one block");
 
-// ─── Difficulty Settings ────────────────────────────────────────────────────
-static const uint16_t diff_speed[] = {140, 120, 90};
-static const uint16_t diff_min_speed[] = {70, 50, 35};
-static const uint8_t diff_spawn[] = {15, 12, 9};
+// The game loop sleeps on these thread flags. Input events wait in their
+// own queue and are always handled before a tick; ticks are only counted,
+// so a stall costs one catch-up frame instead of a backlog of events.
+#define LOOP_FLAG_TICK (1UL << 0)
+#define LOOP_FLAG_INPUT (1UL << 1)
+#define LOOP_FLAG_DRAWN (1UL << 2) // A frame held back behind a slow draw can go out
+#define INPUT_QUEUE_LEN 16
 
-// ─── High Score ─────────────────────────────────────────────────────────────
+// Everything draw_callback needs, copied out of RaceGameState by the game
+// loop. Only live entities are copied, densely packed.
+typedef struct {
+    GameState state;
+    bool night_mode;
+    bool sound_on;
+    bool slide;
+    int8_t menu_idx;
+    Difficulty difficulty;
+    int8_t player_lane;
+    bool player_visible;
+    bool shield;
+    bool magnet;
+    bool show_combo;
+    bool playback;
+    bool ghost_visible;
+    int8_t ghost_lane;
+    uint32_t score;
+    uint32_t high_score;
+    uint16_t level;
+    uint8_t lives;
+    uint8_t combo;
+    uint8_t rank;
+    int16_t road_scroll;
+    uint32_t tick_count;
+    uint8_t obs_count;
+    uint8_t coin_count;
+    uint8_t pw_count;
+    uint8_t particle_count;
+    EntityView obstacles[MAX_OBS];
+    EntityView coins[MAX_COINS];
+    EntityView powerups[MAX_POWERUPS];
+    SceneryLayer scenery[LayerCount];
+    Particle particles[MAX_PARTICLES];
+    BenchReport bench;
+    MemReport mem;
+    SuiteReport suite;
+    bool profiler;
+    ProfView sim_prof[ProfCoreCount];
+    uint32_t missed_ticks;
+} RenderSnapshot;
+
+// Triple buffer: the game loop fills `back` and swaps it into `ready`; the
+// GUI thread swaps a fresh `ready` into `front`. Neither side ever waits and
+// the buffer being drawn is never written.
+#define SNAP_FRESH 0x80
+// HUD text is rebuilt only when the number behind it changes. Digits sit
+// right-aligned in `buf` and increases are added in place with a carry, so
+// a score bump rewrites only the digits that actually change.
+#define HUD_DIGITS 10 // Enough for any uint32_t
+typedef struct {
+    char buf[HUD_DIGITS + 1];
+    uint8_t start; // Index of the first digit
+    uint32_t value;
+    bool valid;
+} HudNumber;
 
-static void load_high_score(RaceGameState* s) {
-    Storage* st = furi_record_open(RECORD_STORAGE);
+typedef struct {
+    HudNumber score;
+    HudNumber level;
+    HudNumber combo;
+    HudNumber best;
+    char line[24]; // "S:<score> L:<level>"
+    char combo_text[HUD_DIGITS + 2];
+    char best_text[HUD_DIGITS + 7];
+    uint8_t line_x; // Left of the centred line
+    uint8_t line_w;
+} HudCache;
+
+typedef struct RenderExchange {
+    RenderSnapshot buf[3];
+    uint8_t road_layer[ROAD_LAYER_H * ROAD_LAYER_STRIDE]; // XBM, GUI thread only
+    uint8_t particle_layer[SCREEN_H * (SCREEN_W / 8)]; // XBM scratch, GUI thread only
+    HudCache hud; // GUI thread only
+    ProfStat draw_prof[ProfDrawCount]; // GUI thread only
+    uint8_t back; // Game loop only
+    uint8_t front; // GUI thread only
+    uint8_t ready; // Buffer index | SNAP_FRESH, swapped atomically
+    // Redraws are paced by draw completion: while a requested frame has not
+    // been drawn yet, newer ones wait instead of queueing another redraw
+    FuriThreadId loop_thread;
+    uint32_t requested; // Redraw requests made, atomic
+    uint32_t requested_ms; // Game loop only
+    uint32_t drawn; // `requested` as seen by the last finished draw, atomic
+    bool deferred; // The loop is waiting on a draw, atomic
+    uint32_t draw_cycles; // Of the last finished draw, atomic
+} RenderExchange;
+
+// ─── Persistence ────────────────────────────────────────────────────────────
+// A worker thread owns the storage handle and does all SD writes. Saves only
+// update a pending payload and queue its kind once; the worker coalesces
+// whatever is queued and writes each kind atomically (temp file + rename).
+// Once a ghost is open the worker also refills its stream, so racing it
+// never waits on the SD card; ghost_open() itself still reads and checks
+// the whole file on the game loop.
+
+typedef enum {
+    PersistSave,
+    PersistReplay,
+    PersistGhost,
+    PersistSuite,
+    PersistKindCount,
+    PersistStop = 0xFF,
+} PersistKind;
+
+// The best run's replay, streamed from SD in two buffers. The game loop
+// drains one while the worker refills the other; `filled` hands them over.
+typedef struct Ghost {
+    FuriMutex* mutex; // Held by the worker while it reads `file`
+    File* file;
+    ReplayHeader hdr;
+    uint16_t left; // Event bytes not yet read; worker once streaming
+    uint8_t chunk[2][GHOST_CHUNK];
+    uint8_t len[2];
+    uint8_t filled; // Bit per chunk with data for the game loop, atomic
+    // Game loop only
+    uint8_t front;
+    uint8_t pos;
+    uint32_t last_step;
+    uint16_t consumed; // Event bytes decoded
+    uint32_t next_step; // Step of the decoded, not yet applied event
+    bool pending; // next_step and lane are valid
+    bool done; // The ghost's run has ended
+    int8_t lane;
+    int8_t next_lane;
+} Ghost;
+
+static const char* const ghost_paths[DIFF_COUNT] = {
+    APP_DATA_PATH("best_easy.rpl"),
+    APP_DATA_PATH("best_normal.rpl"),
+    APP_DATA_PATH("best_hard.rpl"),
+};
+
+typedef struct Persist {
+    FuriThread* thread;
+    FuriMessageQueue* queue; // PersistKind
+    FuriMutex* mutex; // Guards the pending payloads and `queued`
+    Storage* storage;
+    uint32_t queued; // Kinds already in the queue
+    SaveRecord save;
+    ReplayHeader replay_hdr;
+    bool replay_best; // Also store the replay as its difficulty's ghost
+    uint8_t replay[REPLAY_MAX];
+    uint8_t io_buf[sizeof(ReplayHeader) + REPLAY_MAX]; // Worker only
+    Ghost ghost;
+    SuiteRecord suite;
+    bool suite_base; // Also store the suite run as the baseline
+} Persist;
+
+static bool persist_read(Storage* st, const char* path, void* data, size_t size) {
     File* f = storage_file_alloc(st);
-    s->high_score = 0;
-    if(storage_file_open(f, HIGHSCORE_PATH, FSAM_READ, FSOM_OPEN_EXISTING))
-        storage_file_read(f, &s->high_score, sizeof(uint32_t));
+    bool ok = storage_file_open(f, path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_read(f, data, size) == size;
     storage_file_close(f);
     storage_file_free(f);
-    furi_record_close(RECORD_STORAGE);
+    return ok;
 }
 
-static void save_high_score(RaceGameState* s) {
-    if(s->score <= s->high_score) return;
-    s->high_score = s->score;
-    Storage* st = furi_record_open(RECORD_STORAGE);
+static bool persist_write(Storage* st, const char* path, const char* tmp, const void* data, size_t size) {
     File* f = storage_file_alloc(st);
-    if(storage_file_open(f, HIGHSCORE_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS))
-        storage_file_write(f, &s->high_score, sizeof(uint32_t));
+    bool ok = storage_file_open(f, tmp, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+              storage_file_write(f, data, size) == size;
     storage_file_close(f);
     storage_file_free(f);
-    furi_record_close(RECORD_STORAGE);
+    if(!ok) return false;
+    storage_common_remove(st, path);
+    return storage_common_rename(st, tmp, path) == FSE_OK;
 }
 
-// ─── Sound & Vibration ──────────────────────────────────────────────────────
+// Start from CRC32_INIT and invert the end result, or use crc32()
+#define CRC32_INIT 0xFFFFFFFF
+static uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+    const uint8_t* b = data;
+    while(len--) {
+        crc ^= *b++;
+        for(int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return crc;
+}
 
-static void play_sound(RaceGameState* s, float freq, float vol, uint32_t ms) {
-    if(!s->sound_on) return;
-    if(furi_hal_speaker_acquire(500)) {
-        furi_hal_speaker_start(freq, vol);
-        furi_delay_ms(ms);
-        furi_hal_speaker_stop();
-        furi_hal_speaker_release();
+static uint32_t crc32(const void* data, size_t len) {
+    return ~crc32_update(CRC32_INIT, data, len);
+}
+
+// Tops up every chunk the game loop has handed back
+static void ghost_fill(Ghost* g) {
+    furi_mutex_acquire(g->mutex, FuriWaitForever);
+    for(uint8_t k = 0; k < 2 && g->file; k++) {
+        if(__atomic_load_n(&g->filled, __ATOMIC_ACQUIRE) & (1 << k)) continue;
+        uint8_t n = g->left < GHOST_CHUNK ? g->left : GHOST_CHUNK;
+        if(!n || storage_file_read(g->file, g->chunk[k], n) != n) break;
+        g->len[k] = n;
+        g->left -= n;
+        __atomic_fetch_or(&g->filled, 1 << k, __ATOMIC_RELEASE);
     }
+    furi_mutex_release(g->mutex);
 }
 
-static void vibrate(uint32_t ms) {
-    furi_hal_vibro_on(true);
-    furi_delay_ms(ms);
-    furi_hal_vibro_on(false);
+static void persist_flush(Persist* p, PersistKind kind) {
+    switch(kind) {
+    case PersistSave: {
+        furi_mutex_acquire(p->mutex, FuriWaitForever);
+        SaveRecord rec = p->save;
+        furi_mutex_release(p->mutex);
+        rec.crc = crc32(&rec, offsetof(SaveRecord, crc));
+        persist_write(p->storage, SAVE_PATH, SAVE_TMP_PATH, &rec, sizeof(rec));
+        break;
+    }
+    case PersistReplay: {
+        // Copied out so the mutex is not held across the SD write
+        uint8_t* buf = p->io_buf;
+        furi_mutex_acquire(p->mutex, FuriWaitForever);
+        uint16_t len = p->replay_hdr.len;
+        uint8_t diff = p->replay_hdr.difficulty;
+        bool best = p->replay_best;
+        memcpy(buf, &p->replay_hdr, sizeof(ReplayHeader));
+        memcpy(buf + sizeof(ReplayHeader), p->replay, len);
+        furi_mutex_release(p->mutex);
+        persist_write(p->storage, REPLAY_PATH, REPLAY_TMP_PATH, buf, sizeof(ReplayHeader) + len);
+        if(best) persist_write(p->storage, ghost_paths[diff], REPLAY_TMP_PATH, buf, sizeof(ReplayHeader) + len);
+        break;
+    }
+    case PersistGhost:
+        ghost_fill(&p->ghost);
+        break;
+    case PersistSuite: {
+        furi_mutex_acquire(p->mutex, FuriWaitForever);
+        SuiteRecord rec = p->suite;
+        bool base = p->suite_base;
+        furi_mutex_release(p->mutex);
+        // Whole rows only: a row that doesn't fit ends the file
+        char* csv = (char*)p->io_buf;
+        const size_t cap = sizeof(p->io_buf);
+        int w = snprintf(
+            csv,
+            cap,
+            "scenario,lanes,sim_avg_" SUITE_UNIT ",sim_max_" SUITE_UNIT ",draw_avg_" SUITE_UNIT
+            ",draw_max_" SUITE_UNIT "\n");
+        size_t n = w > 0 && (size_t)w < cap ? (size_t)w : 0;
+        for(uint8_t i = 0; n && i < rec.count; i++) {
+            const SuiteTiming* st = &rec.t[i];
+            w = snprintf(
+                csv + n,
+                cap - n,
+                "%s,%u,%lu,%lu,%lu,%lu\n",
+                st->name,
+                rec.lanes,
+                (unsigned long)st->sim_avg,
+                (unsigned long)st->sim_max,
+                (unsigned long)st->draw_avg,
+                (unsigned long)st->draw_max);
+            if(w < 0 || (size_t)w >= cap - n) break;
+            n += w;
+        }
+        persist_write(p->storage, SUITE_CSV_PATH, SUITE_TMP_PATH, csv, n);
+        if(base) persist_write(p->storage, SUITE_BASE_PATH, SUITE_TMP_PATH, &rec, sizeof(rec));
+        break;
+    }
+    default:
+        break;
+    }
 }
 
-// ─── Helpers ────────────────────────────────────────────────────────────────
+static int32_t persist_worker(void* ctx) {
+    Persist* p = ctx;
+    bool running = true;
+
+    while(running) {
+        uint8_t kind;
+        if(furi_message_queue_get(p->queue, &kind, FuriWaitForever) != FuriStatusOk) continue;
+
+        // Drain everything queued so far, then write each kind once
+        uint32_t dirty = 0;
+        do {
+            if(kind == PersistStop)
+                running = false;
+            else
+                dirty |= 1UL << kind;
+        } while(furi_message_queue_get(p->queue, &kind, 0) == FuriStatusOk);
+
+        furi_mutex_acquire(p->mutex, FuriWaitForever);
+        p->queued &= ~dirty;
+        furi_mutex_release(p->mutex);
+
+        for(uint8_t k = 0; k < PersistKindCount; k++)
+            if(dirty & (1UL << k)) persist_flush(p, k);
+    }
+    return 0;
+}
 
-static int16_t lane_cx(int8_t lane) {
-    return ROAD_LEFT + LANE_WIDTH / 2 + lane * LANE_WIDTH;
+static void persist_init(Persist* p) {
+    p->storage = furi_record_open(RECORD_STORAGE);
+    p->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    p->ghost.mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    p->queue = furi_message_queue_alloc(PersistKindCount + 1, sizeof(uint8_t));
+    p->thread = furi_thread_alloc_ex("RacePersist", PERSIST_STACK, persist_worker, p);
+    furi_thread_start(p->thread);
 }
-static int16_t car_lx(int8_t lane) {
-    return lane_cx(lane) - CAR_W / 2;
+
+// Pending saves are written before the worker exits
+static void persist_deinit(Persist* p) {
+    uint8_t kind = PersistStop;
+    furi_message_queue_put(p->queue, &kind, FuriWaitForever);
+    furi_thread_join(p->thread);
+    furi_thread_free(p->thread);
+    furi_message_queue_free(p->queue);
+    if(p->ghost.file) {
+        storage_file_close(p->ghost.file);
+        storage_file_free(p->ghost.file);
+    }
+    furi_mutex_free(p->ghost.mutex);
+    furi_mutex_free(p->mutex);
+    furi_record_close(RECORD_STORAGE);
 }
 
-// ─── Particles ──────────────────────────────────────────────────────────────
+// Call with the mutex held, after updating the kind's payload
+static void persist_queue(Persist* p, PersistKind kind) {
+    if(p->queued & (1UL << kind)) return;
+    p->queued |= 1UL << kind;
+    uint8_t msg = kind;
+    furi_message_queue_put(p->queue, &msg, 0);
+}
+
+// ─── Save Data ──────────────────────────────────────────────────────────────
+
+static bool save_valid(const SaveRecord* rec) {
+    return rec->magic == SAVE_MAGIC && rec->version == SAVE_VERSION &&
+           rec->size == sizeof(SaveRecord) && rec->difficulty < DIFF_COUNT &&
+           rec->crc == crc32(rec, offsetof(SaveRecord, crc));
+}
 
-static void spawn_particles(RaceGameState* s, int16_t cx, int16_t cy) {
-    for(int i = 0; i < MAX_PARTICLES; i++) {
-        s->particles[i].x = cx;
-        s->particles[i].y = cy;
-        s->particles[i].dx = (rand() % 7) - 3;
-        s->particles[i].dy = (rand() % 7) - 3;
-        s->particles[i].life = 8 + (rand() % 5);
+static void save_defaults(SaveRecord* rec) {
+    memset(rec, 0, sizeof(SaveRecord));
+    rec->magic = SAVE_MAGIC;
+    rec->version = SAVE_VERSION;
+    rec->size = sizeof(SaveRecord);
+    rec->difficulty = DiffNormal;
+    rec->flags = SAVE_FLAG_SOUND;
+}
+
+static void save_commit(RaceGameState* s) {
+    s->save.difficulty = s->difficulty;
+    s->save.flags = (s->sound_on ? SAVE_FLAG_SOUND : 0) | (s->night_mode ? SAVE_FLAG_NIGHT : 0) |
+                    (s->slide ? SAVE_FLAG_SLIDE : 0);
+
+    Persist* p = s->persist;
+    furi_mutex_acquire(p->mutex, FuriWaitForever);
+    p->save = s->save;
+    persist_queue(p, PersistSave);
+    furi_mutex_release(p->mutex);
+}
+
+static void load_save(RaceGameState* s) {
+    Storage* st = s->persist->storage;
+    SaveRecord* rec = &s->save;
+    bool migrated = false;
+
+    // A bad main file with a good temp copy means a save was cut off mid-rename
+    if(!(persist_read(st, SAVE_PATH, rec, sizeof(SaveRecord)) && save_valid(rec)) &&
+       !(persist_read(st, SAVE_TMP_PATH, rec, sizeof(SaveRecord)) && save_valid(rec))) {
+        save_defaults(rec);
+        // Migrate the old shared high score into the default difficulty
+        uint32_t legacy;
+        if(persist_read(st, HIGHSCORE_PATH, &legacy, sizeof(legacy))) {
+            rec->top[DiffNormal][0] = legacy;
+            migrated = true;
+        }
     }
+
+    s->difficulty = rec->difficulty;
+    s->sound_on = rec->flags & SAVE_FLAG_SOUND;
+    s->night_mode = rec->flags & SAVE_FLAG_NIGHT;
+    s->slide = rec->flags & SAVE_FLAG_SLIDE;
+    s->high_score = rec->top[s->difficulty][0];
+    // Only now: save_commit() rebuilds the record from the fields above
+    if(migrated) save_commit(s);
 }
 
-static void update_particles(RaceGameState* s) {
-    for(int i = 0; i < MAX_PARTICLES; i++) {
-        if(s->particles[i].life > 0) {
-            s->particles[i].x += s->particles[i].dx;
-            s->particles[i].y += s->particles[i].dy;
-            s->particles[i].life--;
+// Records the finished run in its difficulty's leaderboard and stats
+static void save_run(RaceGameState* s) {
+    const RaceSim* sim = &s->sim;
+    uint32_t* top = s->save.top[sim->difficulty];
+    s->rank = RANK_NONE;
+    for(uint8_t i = 0; i < TOP_N; i++) {
+        if(sim->score > top[i]) {
+            memmove(&top[i + 1], &top[i], (TOP_N - 1 - i) * sizeof(uint32_t));
+            top[i] = sim->score;
+            s->rank = i;
+            break;
         }
     }
+    s->save.runs++;
+    s->save.coins += sim->run_coins;
+    s->high_score = top[0];
+    save_commit(s);
 }
 
-static void draw_particles(Canvas* canvas, RaceGameState* s) {
-    uint8_t fg = s->night_mode ? ColorWhite : ColorBlack;
-    canvas_set_color(canvas, fg);
-    for(int i = 0; i < MAX_PARTICLES; i++) {
-        if(s->particles[i].life > 0) {
-            int16_t px = s->particles[i].x;
-            int16_t py = s->particles[i].y;
-            if(px >= 0 && px < SCREEN_W && py >= 0 && py < SCREEN_H) {
-                canvas_draw_dot(canvas, px, py);
-                if(s->particles[i].life > 4 && px + 1 < SCREEN_W)
-                    canvas_draw_dot(canvas, px + 1, py);
-            }
+// ─── Sound ──────────────────────────────────────────────────────────────────
+// Sounds are short note sequences played by a worker thread, so the game
+// loop only pushes a command and never waits on the speaker.
+
+enum { SndStop = SndCount }; // Worker exit, after the RaceSound ids
+
+typedef struct { uint16_t freq; uint8_t ms; } SoundNote; // freq 0 = rest
+typedef struct { const SoundNote* notes; uint8_t count; float vol; } SoundSeq;
+typedef struct { uint8_t id; int16_t pitch; } SoundCmd;     // pitch is added to every note
+
+typedef struct SoundEngine {
+    FuriThread* thread;
+    FuriMessageQueue* queue;
+} SoundEngine;
+
+static const SoundNote snd_lane[] = {{440, 12}};
+static const SoundNote snd_coin[] = {{1200, 12}, {1500, 13}}; // Raised by combo
+static const SoundNote snd_powerup[] = {{660, 40}, {990, 30}};
+static const SoundNote snd_crash[] = {{100, 80}};
+static const SoundNote snd_game_over[] = {{200, 80}, {0, 20}, {120, 80}, {80, 200}};
+static const SoundNote snd_level_up[] = {{880, 40}, {1109, 40}, {1319, 60}};
+
+#define SEQ(n, v) {n, sizeof(n) / sizeof(n[0]), v}
+static const SoundSeq sound_seqs[] = {
+    [SndLane] = SEQ(snd_lane, 1.0f),
+    [SndCoin] = SEQ(snd_coin, 0.8f),
+    [SndPowerUp] = SEQ(snd_powerup, 0.8f),
+    [SndCrash] = SEQ(snd_crash, 1.0f),
+    [SndGameOver] = SEQ(snd_game_over, 1.0f),
+    [SndLevelUp] = SEQ(snd_level_up, 1.0f),
+};
+#undef SEQ
+
+static int32_t sound_worker(void* ctx) {
+    SoundEngine* e = ctx;
+    SoundCmd cmd;
+    bool pending = false;
+
+    for(;;) {
+        if(!pending && furi_message_queue_get(e->queue, &cmd, FuriWaitForever) != FuriStatusOk)
+            continue;
+        pending = false;
+        if(cmd.id == SndStop) break;
+        if(!furi_hal_speaker_acquire(100)) continue;
+
+        const SoundSeq* seq = &sound_seqs[cmd.id];
+        for(uint8_t i = 0; i < seq->count && !pending; i++) {
+            const SoundNote* n = &seq->notes[i];
+            if(n->freq)
+                furi_hal_speaker_start(n->freq + cmd.pitch, seq->vol);
+            else
+                furi_hal_speaker_stop();
+            // A newer sound cuts the current one short
+            pending = furi_message_queue_get(e->queue, &cmd, furi_ms_to_ticks(n->ms)) ==
+                      FuriStatusOk;
         }
+        furi_hal_speaker_stop();
+        furi_hal_speaker_release();
     }
+    return 0;
 }
 
-// ─── Drawing: Cars ──────────────────────────────────────────────────────────
+static void sound_engine_init(SoundEngine* e) {
+    e->queue = furi_message_queue_alloc(4, sizeof(SoundCmd));
+    e->thread = furi_thread_alloc_ex("RaceSound", SOUND_STACK, sound_worker, e);
+    furi_thread_start(e->thread);
+}
 
-static void draw_player_car(Canvas* canvas, int16_t x, int16_t y, bool night, bool shield) {
-    uint8_t fg = night ? ColorWhite : ColorBlack;
-    uint8_t bg = night ? ColorBlack : ColorWhite;
+static void sound_engine_deinit(SoundEngine* e) {
+    SoundCmd cmd = {.id = SndStop};
+    furi_message_queue_put(e->queue, &cmd, FuriWaitForever);
+    furi_thread_join(e->thread);
+    furi_thread_free(e->thread);
+    furi_message_queue_free(e->queue);
+}
 
-    canvas_set_color(canvas, fg);
-    canvas_draw_box(canvas, x + 3, y, 4, 3);
-    canvas_draw_frame(canvas, x + 2, y + 3, 6, 4);
-    canvas_draw_box(canvas, x + 2, y + 7, 6, 4);
-    canvas_draw_box(canvas, x + 1, y + 11, 8, 2);
-    canvas_draw_box(canvas, x, y + 2, 2, 3);
-    canvas_draw_box(canvas, x + 8, y + 2, 2, 3);
-    canvas_draw_box(canvas, x, y + 8, 2, 3);
-    canvas_draw_box(canvas, x + 8, y + 8, 2, 3);
+static void play_sound(RaceGameState* s, RaceSound id, int16_t pitch) {
+    if(!s->sound_on) return;
+    SoundCmd cmd = {.id = id, .pitch = pitch};
+    furi_message_queue_put(s->sound->queue, &cmd, 0);
+}
 
-    canvas_set_color(canvas, bg);
-    canvas_draw_box(canvas, x + 3, y + 4, 4, 2);
-    canvas_set_color(canvas, fg);
-    canvas_draw_dot(canvas, x + 4, y + 5);
-    canvas_draw_dot(canvas, x + 5, y + 5);
+// ─── Vibration ──────────────────────────────────────────────────────────────
+// Haptic patterns are step tables walked by a worker thread. Requests are
+// merged into a single pending slot: a pattern only replaces the one that is
+// playing (or pending) when its priority is at least as high.
+
+enum { HapNone = 0, HapStop = HapCount }; // Around the RaceHaptic ids
+
+typedef struct { bool on; uint8_t ms; } HapticStep;
+typedef struct { const HapticStep* steps; uint8_t count; uint8_t prio; } HapticPattern;
+
+typedef struct HapticEngine {
+    FuriThread* thread;
+    uint8_t pending; // RaceHaptic, HapNone or HapStop, accessed atomically
+} HapticEngine;
+
+#define HAPTIC_FLAG_KICK (1UL << 0)
+
+static const HapticStep hap_pulse[] = {{true, 80}};
+static const HapticStep hap_double_pulse[] = {{true, 40}, {false, 50}, {true, 40}};
+// Duty cycle drops off so the buzz appears to fade out
+static const HapticStep hap_fade[] = {
+    {true, 70}, {false, 10}, {true, 45}, {false, 20}, {true, 25}, {false, 30}, {true, 12}};
+
+#define PAT(n, p) {n, sizeof(n) / sizeof(n[0]), p}
+static const HapticPattern haptic_patterns[] = {
+    [HapPulse] = PAT(hap_pulse, 1),
+    [HapDoublePulse] = PAT(hap_double_pulse, 1),
+    [HapFade] = PAT(hap_fade, 2),
+};
+#undef PAT
+
+static int32_t haptic_worker(void* ctx) {
+    HapticEngine* h = ctx;
+    const HapticPattern* cur = NULL;
+    uint8_t step = 0;
+    uint32_t step_end = 0;
+
+    for(;;) {
+        uint32_t timeout = FuriWaitForever;
+        if(cur) {
+            int32_t left = (int32_t)(step_end - furi_get_tick());
+            timeout = left > 0 ? (uint32_t)left : 0;
+        }
 
-    // Shield aura
-    if(shield) {
-        canvas_draw_frame(canvas, x - 2, y - 2, CAR_W + 4, CAR_H + 4);
+        bool advance = false;
+        uint32_t flags = furi_thread_flags_wait(HAPTIC_FLAG_KICK, FuriFlagWaitAny, timeout);
+        if(flags & FuriFlagError) {
+            advance = cur != NULL; // Current step elapsed
+        } else {
+            uint8_t id = __atomic_exchange_n(&h->pending, HapNone, __ATOMIC_ACQ_REL);
+            if(id == HapStop) break;
+            if(id != HapNone && (!cur || haptic_patterns[id].prio >= cur->prio)) {
+                cur = &haptic_patterns[id];
+                step = 0;
+                advance = true;
+            }
+        }
+        if(!advance) continue;
+
+        if(flags & FuriFlagError) step++;
+        if(step >= cur->count) {
+            furi_hal_vibro_on(false);
+            cur = NULL;
+        } else {
+            furi_hal_vibro_on(cur->steps[step].on);
+            step_end = furi_get_tick() + furi_ms_to_ticks(cur->steps[step].ms);
+        }
     }
+
+    furi_hal_vibro_on(false);
+    return 0;
 }
 
-static void draw_moto(Canvas* canvas, int16_t x, int16_t y, bool night) {
-    uint8_t fg = night ? ColorWhite : ColorBlack;
-    canvas_set_color(canvas, fg);
-    // Narrow bike shape
-    canvas_draw_box(canvas, x + 4, y, 2, 10);  // Body
-    canvas_draw_box(canvas, x + 3, y + 1, 4, 2); // Handlebars
-    canvas_draw_box(canvas, x + 3, y + 7, 4, 2); // Rear
-    canvas_draw_dot(canvas, x + 4, y + 3); // Rider head
-    canvas_draw_dot(canvas, x + 5, y + 3);
+static void haptic_engine_init(HapticEngine* h) {
+    h->pending = HapNone;
+    h->thread = furi_thread_alloc_ex("RaceHaptic", HAPTIC_STACK, haptic_worker, h);
+    furi_thread_start(h->thread);
 }
 
-static void draw_sedan(Canvas* canvas, int16_t x, int16_t y, bool night) {
-    uint8_t fg = night ? ColorWhite : ColorBlack;
-    uint8_t bg = night ? ColorBlack : ColorWhite;
+static void haptic_engine_deinit(HapticEngine* h) {
+    __atomic_store_n(&h->pending, HapStop, __ATOMIC_RELEASE);
+    furi_thread_flags_set(furi_thread_get_id(h->thread), HAPTIC_FLAG_KICK);
+    furi_thread_join(h->thread);
+    furi_thread_free(h->thread);
+}
 
-    canvas_set_color(canvas, fg);
-    canvas_draw_box(canvas, x + 1, y, 8, 12);
-    canvas_set_color(canvas, bg);
-    canvas_draw_box(canvas, x + 2, y + 2, 6, 3); // Window
-    canvas_set_color(canvas, fg);
-    canvas_draw_box(canvas, x, y + 2, 1, 3);
-    canvas_draw_box(canvas, x + 9, y + 2, 1, 3);
-    canvas_draw_box(canvas, x, y + 9, 1, 3);
-    canvas_draw_box(canvas, x + 9, y + 9, 1, 3);
+static void vibrate(RaceGameState* s, RaceHaptic id) {
+    HapticEngine* h = s->haptics;
+    uint8_t cur = __atomic_load_n(&h->pending, __ATOMIC_ACQUIRE);
+    if(cur != HapNone && haptic_patterns[id].prio < haptic_patterns[cur].prio) return;
+    __atomic_store_n(&h->pending, id, __ATOMIC_RELEASE);
+    furi_thread_flags_set(furi_thread_get_id(h->thread), HAPTIC_FLAG_KICK);
 }
 
-static void draw_boss_truck(Canvas* canvas, int16_t x, int16_t y, bool night) {
-    uint8_t fg = night ? ColorWhite : ColorBlack;
-    uint8_t bg = night ? ColorBlack : ColorWhite;
+// ─── Helpers ────────────────────────────────────────────────────────────────
 
-    // Wide truck spanning ~2 lanes
-    canvas_set_color(canvas, fg);
-    canvas_draw_box(canvas, x, y, 20, 16);
+static void mark_dirty(RaceGameState* s) {
+    s->frame_gen++;
+}
 
-    canvas_set_color(canvas, bg);
-    canvas_draw_box(canvas, x + 2, y + 10, 7, 3); // Left window
-    canvas_draw_box(canvas, x + 11, y + 10, 7, 3); // Right window
-    canvas_draw_box(canvas, x + 3, y + 2, 14, 6);  // Cargo
+// ─── Arena ──────────────────────────────────────────────────────────────────
+// All app state is one block allocated at startup, every part sized at
+// compile time. Only Furi's own objects (threads, queues, mutexes, the
+// timer and view port) are allocated apart from it. A part outgrowing its
+// budget stops the build. Hidden report: hold Left and press Up in the menu.
 
-    canvas_set_color(canvas, fg);
-    // Wheels
-    canvas_draw_box(canvas, x - 1, y + 2, 2, 3);
-    canvas_draw_box(canvas, x + 19, y + 2, 2, 3);
-    canvas_draw_box(canvas, x - 1, y + 11, 2, 3);
-    canvas_draw_box(canvas, x + 19, y + 11, 2, 3);
+typedef struct {
+    RaceGameState game;
+    RenderExchange render;
+    Persist persist;
+    SoundEngine sound;
+    HapticEngine haptics;
+} RaceArena;
+
+_Static_assert(sizeof(RaceGameState) <= GAME_BUDGET, "game state over budget");
+_Static_assert(sizeof(RenderExchange) <= RENDER_BUDGET, "render buffers over budget");
+_Static_assert(sizeof(Persist) <= PERSIST_BUDGET, "persistence over budget");
+_Static_assert(sizeof(SoundEngine) <= SOUND_BUDGET, "sound engine over budget");
+_Static_assert(sizeof(HapticEngine) <= HAPTIC_BUDGET, "haptic engine over budget");
+
+static const char* const mem_part_names[MemPartCount] = {"Game", "Draw", "Save", "Snd", "Vib"};
+static const uint16_t mem_part_size[MemPartCount] = {
+    sizeof(RaceGameState),
+    sizeof(RenderExchange),
+    sizeof(Persist),
+    sizeof(SoundEngine),
+    sizeof(HapticEngine),
+};
+static const uint16_t mem_part_budget[MemPartCount] = {
+    GAME_BUDGET,
+    RENDER_BUDGET,
+    PERSIST_BUDGET,
+    SOUND_BUDGET,
+    HAPTIC_BUDGET,
+};
+static const char* const thread_names[ThreadCount] = {"Main", "Save", "Snd", "Vib"};
+static const uint16_t thread_stack[ThreadCount] = {MAIN_STACK, PERSIST_STACK, SOUND_STACK, HAPTIC_STACK};
+
+static void mem_report(RaceGameState* s) {
+    MemReport* m = &s->mem;
+    m->heap_free = memmgr_get_free_heap();
+    m->heap_min_free = memmgr_get_minimum_free_heap();
+    FuriThreadId ids[ThreadCount] = {
+        s->loop_thread,
+        furi_thread_get_id(s->persist->thread),
+        furi_thread_get_id(s->sound->thread),
+        furi_thread_get_id(s->haptics->thread),
+    };
+    for(int i = 0; i < ThreadCount; i++) m->stack_free[i] = furi_thread_get_stack_space(ids[i]);
+    s->state = StateMemory;
+    mark_dirty(s);
 }
 
-static void draw_obstacle(Canvas* canvas, Obstacle* obs, bool night) {
-    int16_t x = car_lx(obs->lane);
-    switch(obs->type) {
-    case ObsMoto:
-        draw_moto(canvas, x, obs->y, night);
-        break;
-    case ObsSedan:
-        draw_sedan(canvas, x, obs->y, night);
-        break;
-    case ObsTruck:
-        // Boss truck centered between two lanes
-        draw_boss_truck(canvas, x - 5, obs->y, night);
-        break;
-    }
+// ─── Profiler ───────────────────────────────────────────────────────────────
+// Hidden: hold Right in the menu. Sim sections are timed by the core
+// through hal.cycles, draw passes by draw_callback, both on DWT->CYCCNT.
+
+static void prof_add(ProfStat* p, uint32_t cycles) {
+    if(p->n == 0 || cycles < p->min) p->min = cycles;
+    if(cycles > p->max) p->max = cycles;
+    p->sum += cycles;
+    if(++p->n < PROF_WINDOW) return;
+
+    uint32_t mhz = furi_hal_cortex_instructions_per_microsecond();
+    p->out = (ProfView){p->min / mhz, p->sum / PROF_WINDOW / mhz, p->max / mhz};
+    p->n = 0;
+    p->max = 0;
+    p->sum = 0;
 }
 
-// ─── Drawing: Coin ──────────────────────────────────────────────────────────
+static uint32_t hal_cycles(void* ctx) {
+    UNUSED(ctx);
+    return DWT->CYCCNT;
+}
 
-static void draw_coin(Canvas* canvas, int16_t x, int16_t y, bool night, uint32_t tick) {
-    uint8_t fg = night ? ColorWhite : ColorBlack;
-    canvas_set_color(canvas, fg);
-    // Animated sparkle
-    if(tick % 8 < 4) {
-        canvas_draw_circle(canvas, x + 4, y + 4, 3);
-        canvas_draw_dot(canvas, x + 4, y + 4);
-    } else {
-        canvas_draw_circle(canvas, x + 4, y + 4, 3);
-        canvas_draw_dot(canvas, x + 3, y + 3);
-        canvas_draw_dot(canvas, x + 5, y + 5);
-    }
+static void profiler_toggle(RaceGameState* s) {
+    s->profiler = !s->profiler;
+    s->hal.cycles = s->profiler ? hal_cycles : NULL;
+    memset(s->sim_prof, 0, sizeof(s->sim_prof));
+    mark_dirty(s);
 }
 
-// ─── Drawing: Power-Up ──────────────────────────────────────────────────────
+// ─── Particles ──────────────────────────────────────────────────────────────
 
-static void draw_powerup(Canvas* canvas, int16_t x, int16_t y, PowerUpType type, bool night) {
-    uint8_t fg = night ? ColorWhite : ColorBlack;
-    canvas_set_color(canvas, fg);
-    canvas_draw_frame(canvas, x + 1, y, 7, 8);
+// All particles go into one XBM covering their bounding box and are drawn
+// with a single call. The core only hands over on-screen particles.
+static void draw_particles(Canvas* canvas, const RenderSnapshot* r, uint8_t* layer) {
+    if(r->particle_count == 0) return;
+
+    int16_t x0 = SCREEN_W, y0 = SCREEN_H, x1 = 0, y1 = 0;
+    for(int i = 0; i < r->particle_count; i++) {
+        const Particle* pt = &r->particles[i];
+        int16_t xr = pt->life > 4 && pt->x + 1 < SCREEN_W ? pt->x + 1 : pt->x;
+        if(pt->x < x0) x0 = pt->x;
+        if(xr > x1) x1 = xr;
+        if(pt->y < y0) y0 = pt->y;
+        if(pt->y > y1) y1 = pt->y;
+    }
 
-    switch(type) {
-    case PwShield: // S
-        canvas_draw_str(canvas, x + 2, y + 7, "S");
-        break;
-    case PwMagnet: // M
-        canvas_draw_str(canvas, x + 2, y + 7, "M");
-        break;
-    case PwFuel: // +
-        canvas_draw_line(canvas, x + 4, y + 2, x + 4, y + 6);
-        canvas_draw_line(canvas, x + 2, y + 4, x + 6, y + 4);
-        break;
+    uint8_t w = x1 - x0 + 1;
+    uint8_t h = y1 - y0 + 1;
+    uint8_t stride = (w + 7) / 8;
+    memset(layer, 0, stride * h);
+    for(int i = 0; i < r->particle_count; i++) {
+        const Particle* pt = &r->particles[i];
+        uint8_t* row = &layer[(pt->y - y0) * stride];
+        uint8_t x = pt->x - x0;
+        row[x / 8] |= 1 << (x % 8);
+        if(pt->life > 4 && pt->x + 1 < SCREEN_W) row[(x + 1) / 8] |= 1 << ((x + 1) % 8);
     }
+
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_xbm(canvas, x0, y0, w, h, layer);
 }
 
-// ─── Drawing: Scenery ───────────────────────────────────────────────────────
+// ─── Drawing: Sprites ───────────────────────────────────────────────────────
+
+// Everything is drawn in day colors; night mode inverts the finished frame
+static void draw_sprite(Canvas* canvas, const Sprite* sp, int16_t x, int16_t y) {
+    if(sp->holes) {
+        canvas_set_color(canvas, ColorWhite);
+        canvas_draw_xbm(canvas, x + sp->ox, y, sp->w, sp->h, sp->holes);
+    }
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_xbm(canvas, x + sp->ox, y, sp->w, sp->h, sp->bits);
+}
 
-static void draw_scenery_item(Canvas* canvas, Scenery* sc, bool night) {
-    uint8_t fg = night ? ColorWhite : ColorBlack;
-    canvas_set_color(canvas, fg);
-    int16_t x = (sc->side == 0) ? 1 : ROAD_RIGHT + 3;
+static void draw_player_car(Canvas* canvas, int16_t x, int16_t y, bool shield) {
+    draw_sprite(canvas, &spr_player, x, y);
 
-    if(sc->type == 0) {
-        canvas_draw_dot(canvas, x + 2, sc->y);
-        canvas_draw_line(canvas, x + 1, sc->y + 1, x + 3, sc->y + 1);
-        canvas_draw_line(canvas, x, sc->y + 2, x + 4, sc->y + 2);
-        canvas_draw_dot(canvas, x + 2, sc->y + 3);
-        canvas_draw_dot(canvas, x + 2, sc->y + 4);
-    } else {
-        canvas_draw_box(canvas, x + 2, sc->y, 1, 5);
-        canvas_draw_line(canvas, x, sc->y, x + 4, sc->y);
+    // Shield aura
+    if(shield) {
+        canvas_draw_frame(canvas, x - 2, y - 2, CAR_W + 4, CAR_H + 4);
     }
 }
 
+// Just an outline, so it never hides the traffic
+static void draw_ghost_car(Canvas* canvas, int16_t x, int16_t y) {
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_rframe(canvas, x, y, CAR_W, CAR_H, 2);
+}
+
+static const Sprite* const obs_sprites[ObsCount] = {
+    [ObsMoto] = &spr_moto,
+    [ObsSedan] = &spr_sedan,
+    [ObsTruck] = &spr_truck,
+};
+
+static void draw_obstacle(Canvas* canvas, const EntityView* obs) {
+    draw_sprite(canvas, obs_sprites[obs->type], car_lx(obs->lane), FX_PX(obs->y));
+}
+
 // ─── Drawing: Road ──────────────────────────────────────────────────────────
 
-static void draw_road(Canvas* canvas, RaceGameState* s) {
-    uint8_t fg = s->night_mode ? ColorWhite : ColorBlack;
-    canvas_set_color(canvas, fg);
-
-    canvas_draw_line(canvas, ROAD_LEFT, 0, ROAD_LEFT, SCREEN_H - 1);
-    canvas_draw_line(canvas, ROAD_LEFT - 1, 0, ROAD_LEFT - 1, SCREEN_H - 1);
-    canvas_draw_line(canvas, ROAD_RIGHT, 0, ROAD_RIGHT, SCREEN_H - 1);
-    canvas_draw_line(canvas, ROAD_RIGHT + 1, 0, ROAD_RIGHT + 1, SCREEN_H - 1);
-
-    for(int ld = 1; ld < LANE_COUNT; ld++) {
-        int16_t dx = ROAD_LEFT + ld * LANE_WIDTH;
-        for(int16_t dy = -DASH_TOTAL + s->road_scroll; dy < SCREEN_H; dy += DASH_TOTAL) {
-            int16_t st = dy < 0 ? 0 : dy;
-            int16_t en = dy + DASH_LEN - 1;
-            if(en >= SCREEN_H) en = SCREEN_H - 1;
-            if(st <= en) canvas_draw_line(canvas, dx, st, dx, en);
-        }
+static void road_layer_set(uint8_t* layer, int16_t x, int16_t y) {
+    x -= ROAD_LAYER_X;
+    layer[y * ROAD_LAYER_STRIDE + x / 8] |= 1 << (x % 8);
+}
+
+static void road_layer_build(uint8_t* layer) {
+    memset(layer, 0, ROAD_LAYER_H * ROAD_LAYER_STRIDE);
+    for(int16_t y = 0; y < ROAD_LAYER_H; y++) {
+        road_layer_set(layer, ROAD_LEFT - 1, y);
+        road_layer_set(layer, ROAD_LEFT, y);
+        road_layer_set(layer, ROAD_RIGHT, y);
+        road_layer_set(layer, ROAD_RIGHT + 1, y);
+        if(y % DASH_TOTAL >= DASH_LEN) continue;
+        for(int ld = 1; ld < LANE_COUNT; ld++)
+            road_layer_set(layer, ROAD_LEFT + ld * LANE_WIDTH, y);
     }
 }
 
+// Columns per layer; the far one hugs the screen edges
+static const uint8_t scenery_x[LayerCount][2] = {
+    [LayerFar] = {0, SCREEN_W - 5},
+    [LayerNear] = {ROAD_LEFT - 7, ROAD_RIGHT + 3},
+};
+
+// Only the cells inside the screen window are visited
+static void draw_scenery(Canvas* canvas, const SceneryLayer* l, SceneryLayerId layer) {
+    int16_t top = FX_PX(l->scroll) - SCENERY_CELL_H;
+    for(uint8_t k = 0; k < SCENERY_ROWS; k++, top += SCENERY_CELL_H) {
+        uint8_t c = l->cells[(l->head - k) & (SCENERY_RING - 1)];
+        int16_t y = top + SCENERY_DY(c);
+        if(SCENERY_LEFT(c))
+            draw_sprite(canvas, &spr_scenery[SCENERY_LEFT(c) - 1], scenery_x[layer][0], y);
+        if(SCENERY_RIGHT(c))
+            draw_sprite(canvas, &spr_scenery[SCENERY_RIGHT(c) - 1], scenery_x[layer][1], y);
+    }
+}
+
+// The pattern repeats every DASH_TOTAL rows, so scrolling is just an offset
+static void draw_road(Canvas* canvas, const RenderSnapshot* r, const uint8_t* layer) {
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_xbm(
+        canvas, ROAD_LAYER_X, FX_PX(r->road_scroll) - DASH_TOTAL, ROAD_LAYER_W, ROAD_LAYER_H, layer);
+}
+
 // ─── Drawing: HUD ───────────────────────────────────────────────────────────
 
-static void draw_hud(Canvas* canvas, RaceGameState* s) {
-    uint8_t fg = s->night_mode ? ColorWhite : ColorBlack;
-    uint8_t bg = s->night_mode ? ColorBlack : ColorWhite;
+// Returns true when the digits changed
+static bool hud_number_set(HudNumber* n, uint32_t v) {
+    if(n->valid && v == n->value) return false;
+    if(n->valid && v > n->value) {
+        // Add the difference from the right, growing to the left on carry
+        uint32_t carry = v - n->value;
+        for(int i = HUD_DIGITS - 1; carry; i--) {
+            if(i < n->start) {
+                n->buf[i] = '0';
+                n->start = i;
+            }
+            uint32_t d = n->buf[i] - '0' + carry;
+            n->buf[i] = '0' + d % 10;
+            carry = d / 10;
+        }
+    } else {
+        uint32_t rest = v;
+        int i = HUD_DIGITS;
+        do {
+            n->buf[--i] = '0' + rest % 10;
+            rest /= 10;
+        } while(rest);
+        n->start = i;
+        n->valid = true;
+    }
+    n->value = v;
+    return true;
+}
 
-    char buf[32];
-    snprintf(buf, sizeof(buf), "S:%lu L:%u", (unsigned long)s->score, s->level + 1);
+static char* hud_cat(char* dst, const char* src) {
+    while(*src) *dst++ = *src++;
+    *dst = '\0';
+    return dst;
+}
+
+static const char* hud_digits(const HudNumber* n) {
+    return &n->buf[n->start];
+}
 
+static void draw_hud(Canvas* canvas, const RenderSnapshot* r, HudCache* h) {
     canvas_set_font(canvas, FontSecondary);
-    uint16_t w = canvas_string_width(canvas, buf);
-    uint16_t x = (SCREEN_W - w) / 2;
+    // Both are set before testing, hence `|`
+    if(hud_number_set(&h->score, r->score) | hud_number_set(&h->level, r->level + 1)) {
+        char* p = hud_cat(h->line, "S:");
+        p = hud_cat(p, hud_digits(&h->score));
+        p = hud_cat(p, " L:");
+        hud_cat(p, hud_digits(&h->level));
+        h->line_w = canvas_string_width(canvas, h->line);
+        h->line_x = (SCREEN_W - h->line_w) / 2;
+    }
 
-    canvas_set_color(canvas, bg);
-    canvas_draw_box(canvas, x - 3, 0, w + 6, 11);
-    canvas_set_color(canvas, fg);
-    canvas_draw_frame(canvas, x - 3, 0, w + 6, 11);
-    canvas_draw_str(canvas, x, 9, buf);
+    canvas_set_color(canvas, ColorWhite);
+    canvas_draw_box(canvas, h->line_x - 3, 0, h->line_w + 6, 11);
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_frame(canvas, h->line_x - 3, 0, h->line_w + 6, 11);
+    canvas_draw_str(canvas, h->line_x, 9, h->line);
 
     // Lives (hearts)
-    for(uint8_t i = 0; i < s->lives; i++) {
-        int16_t hx = 1;
-        int16_t hy = SCREEN_H - 8 - i * 7;
-        canvas_draw_dot(canvas, hx + 1, hy);
-        canvas_draw_dot(canvas, hx + 3, hy);
-        canvas_draw_line(canvas, hx, hy + 1, hx + 4, hy + 1);
-        canvas_draw_line(canvas, hx, hy + 2, hx + 4, hy + 2);
-        canvas_draw_line(canvas, hx + 1, hy + 3, hx + 3, hy + 3);
-        canvas_draw_dot(canvas, hx + 2, hy + 4);
-    }
+    for(uint8_t i = 0; i < r->lives; i++)
+        canvas_draw_xbm(canvas, 1, SCREEN_H - 8 - i * 7, spr_heart.w, spr_heart.h, spr_heart.bits);
 
     // Combo display
-    if(s->combo_display > 0 && s->combo > 1) {
-        char cbuf[8];
-        snprintf(cbuf, sizeof(cbuf), "x%u", s->combo);
-        canvas_draw_str_aligned(canvas, SCREEN_W - 2, 14, AlignRight, AlignBottom, cbuf);
+    if(r->show_combo) {
+        if(hud_number_set(&h->combo, r->combo)) hud_cat(hud_cat(h->combo_text, "x"), hud_digits(&h->combo));
+        canvas_draw_str_aligned(canvas, SCREEN_W - 2, 14, AlignRight, AlignBottom, h->combo_text);
     }
 
     // Shield indicator
-    if(s->shield_ticks > 0) {
+    if(r->shield) {
         canvas_draw_str(canvas, ROAD_RIGHT + 3, 20, "S");
     }
     // Magnet indicator
-    if(s->magnet_ticks > 0) {
+    if(r->magnet) {
         canvas_draw_str(canvas, ROAD_RIGHT + 3, 30, "M");
     }
+    // Replay playback indicator
+    if(r->playback) {
+        canvas_draw_str(canvas, 1, 20, "R");
+    }
 }
 
 // ─── Drawing: Menu ──────────────────────────────────────────────────────────
 
 static const char* diff_names[] = {"EASY", "NORMAL", "HARD"};
 
-static void draw_menu(Canvas* canvas, RaceGameState* s) {
+static void draw_menu(Canvas* canvas, const RenderSnapshot* r, HudCache* h) {
     canvas_set_font(canvas, FontPrimary);
     canvas_draw_str_aligned(canvas, SCREEN_W / 2, 15, AlignCenter, AlignBottom, "RACE");
     canvas_draw_str_aligned(canvas, SCREEN_W / 2, 28, AlignCenter, AlignBottom, "GAME");
 
     canvas_set_font(canvas, FontSecondary);
 
-    char hs[24];
-    snprintf(hs, sizeof(hs), "Best: %lu", (unsigned long)s->high_score);
-    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 40, AlignCenter, AlignBottom, hs);
-
-    // 4 menu items: Start, Sound, Night, Difficulty
-    const char* labels[] = {"START", "SOUND", "NIGHT", "DIFF"};
-    for(int i = 0; i < 4; i++) {
-        char buf[24];
-        if(i == 0)
-            snprintf(buf, sizeof(buf), "%sSTART%s", i == s->menu_idx ? "> " : "", i == s->menu_idx ? " <" : "");
-        else if(i == 1)
-            snprintf(buf, sizeof(buf), "%sSOUND:%s%s", i == s->menu_idx ? ">" : "", s->sound_on ? "ON" : "OFF", i == s->menu_idx ? "<" : "");
-        else if(i == 2)
-            snprintf(buf, sizeof(buf), "%sNIGHT:%s%s", i == s->menu_idx ? ">" : "", s->night_mode ? "ON" : "OFF", i == s->menu_idx ? "<" : "");
-        else
-            snprintf(buf, sizeof(buf), "%s%s%s", i == s->menu_idx ? ">" : "", diff_names[s->difficulty], i == s->menu_idx ? "<" : "");
-
-        UNUSED(labels);
-        canvas_draw_str_aligned(canvas, SCREEN_W / 2, 52 + i * 11, AlignCenter, AlignBottom, buf);
+    if(hud_number_set(&h->best, r->high_score)) hud_cat(hud_cat(h->best_text, "Best: "), hud_digits(&h->best));
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 40, AlignCenter, AlignBottom, h->best_text);
+
+    // Menu items: Start, Sound, Night, Slide, Difficulty, Replay, Ghost
+    const char* labels[MenuCount] = {
+        "START",
+        r->sound_on ? "SOUND:ON" : "SOUND:OFF",
+        r->night_mode ? "NIGHT:ON" : "NIGHT:OFF",
+        r->slide ? "SLIDE:ON" : "SLIDE:OFF",
+        diff_names[r->difficulty],
+        "REPLAY",
+        "GHOST",
+    };
+    for(int i = 0; i < MenuCount; i++) {
+        char buf[16];
+        const char* text = labels[i];
+        if(i == r->menu_idx) {
+            bool wide = i == MenuStart;
+            hud_cat(hud_cat(hud_cat(buf, wide ? "> " : ">"), labels[i]), wide ? " <" : "<");
+            text = buf;
+        }
+        canvas_draw_str_aligned(canvas, SCREEN_W / 2, 49 + i * 8, AlignCenter, AlignBottom, text);
     }
 
-    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 102, AlignCenter, AlignBottom, "OK:Select");
-    draw_player_car(canvas, SCREEN_W / 2 - 5, 112, false, false);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 107, AlignCenter, AlignBottom, "OK:Select");
+    if(r->profiler) canvas_draw_str(canvas, 1, 8, "P");
+    draw_player_car(canvas, SCREEN_W / 2 - 5, 113, false);
 }
 
 // ─── Drawing: Game Over ─────────────────────────────────────────────────────
 
-static void draw_game_over(Canvas* canvas, RaceGameState* s) {
-    uint8_t fg = s->night_mode ? ColorWhite : ColorBlack;
-    uint8_t bg = s->night_mode ? ColorBlack : ColorWhite;
-
-    canvas_set_color(canvas, bg);
+static void draw_game_over(Canvas* canvas, const RenderSnapshot* r) {
+    canvas_set_color(canvas, ColorWhite);
     canvas_draw_box(canvas, 4, 28, 56, 70);
-    canvas_set_color(canvas, fg);
+    canvas_set_color(canvas, ColorBlack);
     canvas_draw_frame(canvas, 4, 28, 56, 70);
     canvas_draw_frame(canvas, 5, 29, 54, 68);
 
@@ -445,451 +1150,1059 @@ static void draw_game_over(Canvas* canvas, RaceGameState* s) {
 
     canvas_set_font(canvas, FontSecondary);
     char buf[24];
-    snprintf(buf, sizeof(buf), "Score: %lu", (unsigned long)s->score);
+    snprintf(buf, sizeof(buf), "Score: %lu", (unsigned long)r->score);
     canvas_draw_str_aligned(canvas, SCREEN_W / 2, 68, AlignCenter, AlignBottom, buf);
 
-    if(s->score >= s->high_score && s->score > 0)
+    if(r->rank == 0)
         canvas_draw_str_aligned(canvas, SCREEN_W / 2, 78, AlignCenter, AlignBottom, "NEW BEST!");
-    else {
-        snprintf(buf, sizeof(buf), "Best: %lu", (unsigned long)s->high_score);
+    else if(r->rank != RANK_NONE) {
+        snprintf(buf, sizeof(buf), "Top %u!", r->rank + 1);
+        canvas_draw_str_aligned(canvas, SCREEN_W / 2, 78, AlignCenter, AlignBottom, buf);
+    } else {
+        snprintf(buf, sizeof(buf), "Best: %lu", (unsigned long)r->high_score);
         canvas_draw_str_aligned(canvas, SCREEN_W / 2, 78, AlignCenter, AlignBottom, buf);
     }
 
-    snprintf(buf, sizeof(buf), "Combo: x%u", s->combo > 1 ? s->combo : 1);
+    snprintf(buf, sizeof(buf), "Combo: x%u", r->combo > 1 ? r->combo : 1);
     canvas_draw_str_aligned(canvas, SCREEN_W / 2, 88, AlignCenter, AlignBottom, buf);
 
     canvas_draw_str_aligned(canvas, SCREEN_W / 2, 95, AlignCenter, AlignBottom, "OK: Menu");
 }
 
-// ─── Main Draw ──────────────────────────────────────────────────────────────
+// ─── Drawing: Pause ─────────────────────────────────────────────────────────
 
-static void draw_callback(Canvas* canvas, void* ctx) {
-    RaceGameState* s = ctx;
-    if(!s) return;
-    canvas_clear(canvas);
+static void draw_paused(Canvas* canvas) {
+    canvas_set_color(canvas, ColorWhite);
+    canvas_draw_box(canvas, 4, 34, 56, 60);
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_frame(canvas, 4, 34, 56, 60);
+    canvas_draw_frame(canvas, 5, 35, 54, 58);
 
-    if(s->night_mode && s->state != StateMenu) {
-        canvas_set_color(canvas, ColorBlack);
-        canvas_draw_box(canvas, 0, 0, SCREEN_W, SCREEN_H);
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 49, AlignCenter, AlignBottom, "PAUSED");
+
+    canvas_set_font(canvas, FontSecondary);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 62, AlignCenter, AlignBottom, "OK: Resume");
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 71, AlignCenter, AlignBottom, "Back: Menu");
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 80, AlignCenter, AlignBottom, "Hold Back:");
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 89, AlignCenter, AlignBottom, "Save & Quit");
+}
+
+// ─── Drawing: Bench ─────────────────────────────────────────────────────────
+
+static void draw_bench(Canvas* canvas, const RenderSnapshot* r) {
+    const BenchReport* b = &r->bench;
+    char buf[24];
+
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 15, AlignCenter, AlignBottom, "BENCH");
+
+    canvas_set_font(canvas, FontSecondary);
+    snprintf(buf, sizeof(buf), "Steps: %u", BENCH_STEPS);
+    canvas_draw_str(canvas, 2, 32, buf);
+    snprintf(buf, sizeof(buf), "Runs: %lu", (unsigned long)b->runs);
+    canvas_draw_str(canvas, 2, 42, buf);
+    snprintf(buf, sizeof(buf), "Step/s: %lu", (unsigned long)b->steps_per_sec);
+    canvas_draw_str(canvas, 2, 56, buf);
+    snprintf(buf, sizeof(buf), "Avg: %lu ns", (unsigned long)b->avg_ns);
+    canvas_draw_str(canvas, 2, 66, buf);
+    snprintf(buf, sizeof(buf), "Worst: %lu us", (unsigned long)b->worst_us);
+    canvas_draw_str(canvas, 2, 76, buf);
+    snprintf(buf, sizeof(buf), "Heap: %+ld B", (long)b->heap_delta);
+    canvas_draw_str(canvas, 2, 90, buf);
+
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 120, AlignCenter, AlignBottom, "OK: Menu");
+}
+
+// ─── Drawing: Suite ─────────────────────────────────────────────────────────
+
+// Per scenario: name and frame time against the baseline, then sim/draw
+// time in SUITE_UNIT
+static void draw_suite(Canvas* canvas, const RenderSnapshot* r) {
+    const SuiteReport* rep = &r->suite;
+    char buf[32];
+
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 12, AlignCenter, AlignBottom, "SUITE");
+
+    canvas_set_font(canvas, FontSecondary);
+    int16_t y = 24;
+    for(int i = 0; i < rep->run.count; i++, y += 19) {
+        const SuiteTiming* t = &rep->run.t[i];
+        int32_t d = rep->delta_pct[i];
+        canvas_draw_str(canvas, 2, y, t->name);
+        if(d == SUITE_NO_BASE)
+            snprintf(buf, sizeof(buf), "new");
+        else
+            snprintf(buf, sizeof(buf), "%s%+ld%%", d > SUITE_SLACK_PCT ? "!" : "", (long)d);
+        canvas_draw_str_aligned(canvas, SCREEN_W - 2, y, AlignRight, AlignBottom, buf);
+        snprintf(buf, sizeof(buf), "%lu/%lu " SUITE_UNIT, (unsigned long)t->sim_avg, (unsigned long)t->draw_avg);
+        canvas_draw_str(canvas, 6, y + 8, buf);
     }
 
-    switch(s->state) {
-    case StateMenu:
-        draw_menu(canvas, s);
-        break;
+    if(rep->dropped) {
+        snprintf(buf, sizeof(buf), "Dropped: %u", rep->dropped);
+        canvas_draw_str(canvas, 2, y, buf);
+    } else if(rep->new_base) {
+        canvas_draw_str(canvas, 2, y, "Saved as base");
+    }
 
-    case StatePlaying:
-        for(int i = 0; i < MAX_SCENERY; i++)
-            if(s->scenery[i].y > -10 && s->scenery[i].y < SCREEN_H)
-                draw_scenery_item(canvas, &s->scenery[i], s->night_mode);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, SCREEN_H - 1, AlignCenter, AlignBottom, "OK: Menu");
+}
+
+// ─── Drawing: Memory ────────────────────────────────────────────────────────
 
-        draw_road(canvas, s);
+static void draw_mem_row(Canvas* canvas, int16_t y, const char* label, uint32_t bytes, const char* note) {
+    char buf[12];
+    canvas_draw_str(canvas, 2, y, label);
+    snprintf(buf, sizeof(buf), "%lu", (unsigned long)bytes);
+    canvas_draw_str_aligned(canvas, 40, y, AlignRight, AlignBottom, buf);
+    canvas_draw_str_aligned(canvas, SCREEN_W - 2, y, AlignRight, AlignBottom, note);
+}
 
-        for(int i = 0; i < MAX_COINS; i++)
-            if(s->coins[i].alive)
-                draw_coin(canvas, car_lx(s->coins[i].lane), s->coins[i].y, s->night_mode, s->tick_count);
+// Arena parts show bytes and budget use, threads their free and total stack
+static void draw_memory(Canvas* canvas, const RenderSnapshot* r) {
+    const MemReport* m = &r->mem;
+    char note[12];
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, 12, AlignCenter, AlignBottom, "MEMORY");
 
-        for(int i = 0; i < MAX_POWERUPS; i++)
-            if(s->powerups[i].alive)
-                draw_powerup(canvas, car_lx(s->powerups[i].lane), s->powerups[i].y, s->powerups[i].type, s->night_mode);
+    canvas_set_font(canvas, FontSecondary);
+    int16_t y = 22;
+    draw_mem_row(canvas, y, "Arena", sizeof(RaceArena), "B");
+    for(int i = 0; i < MemPartCount; i++) {
+        snprintf(note, sizeof(note), "%u%%", mem_part_size[i] * 100 / mem_part_budget[i]);
+        draw_mem_row(canvas, y += 8, mem_part_names[i], mem_part_size[i], note);
+    }
+    draw_mem_row(canvas, y += 9, "Heap", m->heap_free, "free");
+    draw_mem_row(canvas, y += 8, "Min", m->heap_min_free, "free");
+    y++;
+    for(int i = 0; i < ThreadCount; i++) {
+        snprintf(note, sizeof(note), "/%u", thread_stack[i]);
+        draw_mem_row(canvas, y += 8, thread_names[i], m->stack_free[i], note);
+    }
 
-        for(int i = 0; i < MAX_OBS; i++)
-            if(s->obstacles[i].alive)
-                draw_obstacle(canvas, &s->obstacles[i], s->night_mode);
+    canvas_draw_str_aligned(canvas, SCREEN_W / 2, SCREEN_H - 1, AlignCenter, AlignBottom, "OK: Menu");
+}
 
-        if(s->invincible_ticks == 0 || (s->tick_count % 4 < 2))
-            draw_player_car(canvas, car_lx(s->player_lane), PLAYER_Y, s->night_mode, s->shield_ticks > 0);
+// ─── Drawing: Profiler ──────────────────────────────────────────────────────
+
+static void draw_prof_line(Canvas* canvas, int16_t y, const char* label, const ProfView* v) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%s %u/%u/%u", label, v->min, v->avg, v->max);
+    canvas_draw_str(canvas, ROAD_LEFT + 2, y, buf);
+}
+
+// Min/avg/max in us per frame; sim sections sum every step of the frame.
+// The side margins are too narrow for a row, so the text goes over the road
+// in XOR, with no box hiding the traffic being timed
+static void draw_profiler(Canvas* canvas, const RenderSnapshot* r, const RenderExchange* x) {
+    static const char* sim_labels[ProfCoreCount] = {"UPD", "COL", "SPN"};
+    static const char* draw_labels[ProfDrawCount] = {"ROD", "SPR", "HUD"};
+
+    canvas_set_font(canvas, FontSecondary);
+    canvas_set_color(canvas, ColorXOR);
+
+    int16_t y = 20;
+    for(int i = 0; i < ProfCoreCount; i++, y += 8)
+        draw_prof_line(canvas, y, sim_labels[i], &r->sim_prof[i]);
+    for(int i = 0; i < ProfDrawCount; i++, y += 8)
+        draw_prof_line(canvas, y, draw_labels[i], &x->draw_prof[i].out);
+
+    char buf[16];
+    snprintf(buf, sizeof(buf), "MISS %lu", (unsigned long)r->missed_ticks);
+    canvas_draw_str(canvas, ROAD_LEFT + 2, y, buf);
+    canvas_set_color(canvas, ColorBlack);
+}
+
+// Closes a draw section when the profiler is on
+static uint32_t draw_lap(RenderExchange* x, const RenderSnapshot* r, ProfDrawSection sec, uint32_t mark) {
+    if(!r->profiler) return 0;
+    uint32_t now = DWT->CYCCNT;
+    prof_add(&x->draw_prof[sec], now - mark);
+    return now;
+}
+
+// ─── Main Draw ──────────────────────────────────────────────────────────────
 
-        draw_particles(canvas, s);
-        draw_hud(canvas, s);
+static void draw_callback(Canvas* canvas, void* ctx) {
+    RenderExchange* x = ctx;
+    if(!x) return;
+    // Read first: the snapshot behind this request is then already published
+    uint32_t serving = __atomic_load_n(&x->requested, __ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&x->ready, __ATOMIC_ACQUIRE) & SNAP_FRESH)
+        x->front = __atomic_exchange_n(&x->ready, x->front, __ATOMIC_ACQ_REL) & ~SNAP_FRESH;
+    const RenderSnapshot* r = &x->buf[x->front];
+    uint32_t begin = DWT->CYCCNT;
+    uint32_t mark = begin;
+    canvas_clear(canvas);
+
+    switch(r->state) {
+    case StateMenu:
+        draw_menu(canvas, r, &x->hud);
+        break;
+
+    case StatePlaying:
+    case StatePaused:
+        for(int i = 0; i < LayerCount; i++)
+            draw_scenery(canvas, &r->scenery[i], i);
+        draw_road(canvas, r, x->road_layer);
+        mark = draw_lap(x, r, ProfDrawRoad, mark);
+
+        // Animated sparkle
+        const Sprite* coin = &spr_coin[r->tick_count / MS_TO_STEPS(400) % 2];
+        for(int i = 0; i < r->coin_count; i++)
+            draw_sprite(canvas, coin, car_lx(r->coins[i].lane), FX_PX(r->coins[i].y));
+
+        for(int i = 0; i < r->pw_count; i++)
+            draw_sprite(
+                canvas,
+                &spr_powerup[r->powerups[i].type],
+                car_lx(r->powerups[i].lane),
+                FX_PX(r->powerups[i].y));
+
+        for(int i = 0; i < r->obs_count; i++)
+            draw_obstacle(canvas, &r->obstacles[i]);
+
+        if(r->ghost_visible) draw_ghost_car(canvas, car_lx(r->ghost_lane), PLAYER_Y);
+        if(r->player_visible)
+            draw_player_car(canvas, car_lx(r->player_lane), PLAYER_Y, r->shield);
+
+        draw_particles(canvas, r, x->particle_layer);
+        mark = draw_lap(x, r, ProfDrawSprites, mark);
+        draw_hud(canvas, r, &x->hud);
+        draw_lap(x, r, ProfDrawHud, mark);
+        if(r->state == StatePaused) draw_paused(canvas);
         break;
 
     case StateGameOver:
-        draw_road(canvas, s);
-        for(int i = 0; i < MAX_OBS; i++)
-            if(s->obstacles[i].alive)
-                draw_obstacle(canvas, &s->obstacles[i], s->night_mode);
-        draw_player_car(canvas, car_lx(s->player_lane), PLAYER_Y, s->night_mode, false);
-        draw_particles(canvas, s);
-        draw_hud(canvas, s);
-        draw_game_over(canvas, s);
+        draw_road(canvas, r, x->road_layer);
+        mark = draw_lap(x, r, ProfDrawRoad, mark);
+        for(int i = 0; i < r->obs_count; i++)
+            draw_obstacle(canvas, &r->obstacles[i]);
+        draw_player_car(canvas, car_lx(r->player_lane), PLAYER_Y, false);
+        draw_particles(canvas, r, x->particle_layer);
+        mark = draw_lap(x, r, ProfDrawSprites, mark);
+        draw_hud(canvas, r, &x->hud);
+        draw_game_over(canvas, r);
+        draw_lap(x, r, ProfDrawHud, mark);
+        break;
+
+    case StateBench:
+        draw_bench(canvas, r);
+        break;
+
+    case StateSuite:
+        draw_suite(canvas, r);
+        break;
+
+    case StateMemory:
+        draw_memory(canvas, r);
         break;
     }
+
+    if(r->profiler && (r->state == StatePlaying || r->state == StateGameOver))
+        draw_profiler(canvas, r, x);
+
+    // Night mode: invert the finished frame in one pass
+    if(r->night_mode && r->state != StateMenu && r->state != StateBench && r->state != StateSuite &&
+       r->state != StateMemory) {
+        canvas_set_color(canvas, ColorXOR);
+        canvas_draw_box(canvas, 0, 0, SCREEN_W, SCREEN_H);
+        canvas_set_color(canvas, ColorBlack);
+    }
+
+    __atomic_store_n(&x->draw_cycles, DWT->CYCCNT - begin, __ATOMIC_RELAXED);
+    __atomic_store_n(&x->drawn, serving, __ATOMIC_RELEASE);
+    if(__atomic_exchange_n(&x->deferred, false, __ATOMIC_ACQ_REL))
+        furi_thread_flags_set(x->loop_thread, LOOP_FLAG_DRAWN);
 }
 
 // ─── Callbacks ──────────────────────────────────────────────────────────────
 
+// The loop drains this queue before any frame work, so a wait here is
+// bounded by one frame
 static void input_callback(InputEvent* ie, void* ctx) {
     furi_assert(ctx);
-    FuriMessageQueue* q = ctx;
-    GameEvent ev = {.type = EventTypeKey, .input = *ie};
-    furi_message_queue_put(q, &ev, FuriWaitForever);
+    RaceGameState* s = ctx;
+    furi_message_queue_put(s->input_queue, ie, FuriWaitForever);
+    furi_thread_flags_set(s->loop_thread, LOOP_FLAG_INPUT);
 }
 
 static void timer_callback(void* ctx) {
     furi_assert(ctx);
-    FuriMessageQueue* q = ctx;
-    GameEvent ev = {.type = EventTypeTick};
-    furi_message_queue_put(q, &ev, 0);
+    RaceGameState* s = ctx;
+    __atomic_fetch_add(&s->pending_ticks, 1, __ATOMIC_RELEASE);
+    furi_thread_flags_set(s->loop_thread, LOOP_FLAG_TICK);
 }
 
-// ─── Init ───────────────────────────────────────────────────────────────────
+// ─── Replay Files ───────────────────────────────────────────────────────────
+
+// `best` also keeps it as the ghost for its difficulty
+static void replay_save(RaceGameState* s, bool best) {
+    Replay* r = &s->sim.replay;
+    r->hdr.magic = REPLAY_MAGIC;
+    r->hdr.version = REPLAY_VERSION;
+    r->hdr.crc = crc32(r->events, r->hdr.len);
+
+    Persist* p = s->persist;
+    furi_mutex_acquire(p->mutex, FuriWaitForever);
+    p->replay_hdr = r->hdr;
+    p->replay_best = best;
+    memcpy(p->replay, r->events, r->hdr.len);
+    persist_queue(p, PersistReplay);
+    furi_mutex_release(p->mutex);
+}
 
-static void init_scenery(RaceGameState* s) {
-    for(int i = 0; i < MAX_SCENERY; i++) {
-        s->scenery[i].y = rand() % SCREEN_H;
-        s->scenery[i].side = rand() % 2;
-        s->scenery[i].type = rand() % 2;
+static bool replay_load(RaceGameState* s) {
+    Replay* r = &s->sim.replay;
+    File* f = storage_file_alloc(s->persist->storage);
+    bool ok = storage_file_open(f, REPLAY_PATH, FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_read(f, &r->hdr, sizeof(ReplayHeader)) == sizeof(ReplayHeader) &&
+              r->hdr.magic == REPLAY_MAGIC && r->hdr.version == REPLAY_VERSION &&
+              r->hdr.len <= REPLAY_MAX && r->hdr.difficulty < DIFF_COUNT &&
+              r->hdr.lanes == LANE_COUNT &&
+              storage_file_read(f, r->events, r->hdr.len) == r->hdr.len &&
+              r->hdr.crc == crc32(r->events, r->hdr.len);
+    storage_file_close(f);
+    storage_file_free(f);
+    return ok;
+}
+
+// ─── Suspend Files ──────────────────────────────────────────────────────────
+// A paused run is written and read back as one flat block, the header and
+// the RaceSim behind it, so quitting and relaunching costs a single storage
+// call each way.
+#define SUSPEND_SIZE (sizeof(SuspendHeader) + sizeof(RaceSim))
+
+static void suspend_save(RaceGameState* s) {
+    s->suspend_hdr = (SuspendHeader){
+        .magic = SUSPEND_MAGIC,
+        .version = SUSPEND_VERSION,
+        .size = sizeof(RaceSim),
+        .lanes = LANE_COUNT,
+        .crc = crc32(&s->sim, sizeof(RaceSim)),
+    };
+    Storage* st = s->persist->storage;
+    File* f = storage_file_alloc(st);
+    bool ok = storage_file_open(f, SUSPEND_TMP_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+              storage_file_write(f, &s->suspend_hdr, SUSPEND_SIZE) == SUSPEND_SIZE;
+    storage_file_close(f);
+    storage_file_free(f);
+    if(!ok) return;
+    storage_common_remove(st, SUSPEND_PATH);
+    storage_common_rename(st, SUSPEND_TMP_PATH, SUSPEND_PATH);
+}
+
+// A stored run is resumed once; the file goes either way
+static bool suspend_load(RaceGameState* s) {
+    const SuspendHeader* h = &s->suspend_hdr;
+    Storage* st = s->persist->storage;
+    File* f = storage_file_alloc(st);
+    bool ok = storage_file_open(f, SUSPEND_PATH, FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_read(f, &s->suspend_hdr, SUSPEND_SIZE) == SUSPEND_SIZE && h->magic == SUSPEND_MAGIC &&
+              h->version == SUSPEND_VERSION && h->size == sizeof(RaceSim) && h->lanes == LANE_COUNT &&
+              h->crc == crc32(&s->sim, sizeof(RaceSim)) && race_sim_resume(&s->sim, &s->hal);
+    storage_file_close(f);
+    storage_file_free(f);
+    storage_common_remove(st, SUSPEND_PATH);
+    if(!ok) {
+        memset(&s->sim, 0, sizeof(RaceSim));
+        s->sim.lives = INITIAL_LIVES;
+        s->sim.hal = &s->hal;
     }
+    return ok;
 }
 
-static void game_init(RaceGameState* s) {
-    s->state = StatePlaying;
-    s->player_lane = 1;
-    s->score = 0;
-    s->level = 0;
-    s->lives = INITIAL_LIVES;
-    s->speed = diff_speed[s->difficulty];
-    s->tick_count = 0;
-    s->road_scroll = 0;
-    s->invincible_ticks = 0;
-    s->shield_ticks = 0;
-    s->magnet_ticks = 0;
-    s->combo = 0;
-    s->combo_display = 0;
-
-    for(int i = 0; i < MAX_OBS; i++) s->obstacles[i].alive = false;
-    for(int i = 0; i < MAX_COINS; i++) s->coins[i].alive = false;
-    for(int i = 0; i < MAX_POWERUPS; i++) s->powerups[i].alive = false;
-    for(int i = 0; i < MAX_PARTICLES; i++) s->particles[i].life = 0;
-
-    init_scenery(s);
-    furi_timer_start(s->timer, s->speed);
-}
-
-// ─── Collision ──────────────────────────────────────────────────────────────
-
-static bool check_collision(RaceGameState* s) {
-    int16_t px = car_lx(s->player_lane);
-    for(int i = 0; i < MAX_OBS; i++) {
-        if(!s->obstacles[i].alive) continue;
-        int16_t ox, ow;
-        if(s->obstacles[i].type == ObsTruck) {
-            ox = car_lx(s->obstacles[i].lane) - 5;
-            ow = 20;
-        } else if(s->obstacles[i].type == ObsMoto) {
-            ox = car_lx(s->obstacles[i].lane) + 2;
-            ow = 6;
-        } else {
-            ox = car_lx(s->obstacles[i].lane);
-            ow = CAR_W;
-        }
-        int16_t oh = (s->obstacles[i].type == ObsTruck) ? 16 : (s->obstacles[i].type == ObsMoto ? 10 : 12);
-        if((px < ox + ow) && (px + CAR_W > ox) &&
-           (PLAYER_Y < s->obstacles[i].y + oh) && (PLAYER_Y + CAR_H > s->obstacles[i].y))
+// ─── Ghost ──────────────────────────────────────────────────────────────────
+// The best run's lane log is decoded a chunk at a time as the race goes on.
+// Only opening touches the SD card on the game loop, before the race starts;
+// after that the loop just takes whichever chunk the worker has filled and
+// the ghost waits in its lane if one is ever late.
+
+static void ghost_close(RaceGameState* s) {
+    Ghost* g = s->ghost;
+    if(!g) return;
+    furi_mutex_acquire(g->mutex, FuriWaitForever);
+    storage_file_close(g->file);
+    storage_file_free(g->file);
+    g->file = NULL;
+    furi_mutex_release(g->mutex);
+    s->ghost = NULL;
+}
+
+// Checks the whole file in GHOST_CHUNK pieces, then leaves it at the first
+// event with both chunks loaded
+static bool ghost_open(RaceGameState* s, Difficulty d) {
+    ghost_close(s);
+    Persist* p = s->persist;
+    Ghost* g = &p->ghost;
+    ReplayHeader* h = &g->hdr;
+    File* f = storage_file_alloc(p->storage);
+    bool ok = storage_file_open(f, ghost_paths[d], FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_read(f, h, sizeof(ReplayHeader)) == sizeof(ReplayHeader) &&
+              h->magic == REPLAY_MAGIC && h->version == REPLAY_VERSION && h->len <= REPLAY_MAX &&
+              h->difficulty == d && h->lanes == LANE_COUNT;
+    uint32_t crc = CRC32_INIT;
+    for(uint16_t left = h->len; ok && left;) {
+        uint8_t n = left < GHOST_CHUNK ? left : GHOST_CHUNK;
+        ok = storage_file_read(f, g->chunk[0], n) == n;
+        crc = crc32_update(crc, g->chunk[0], n);
+        left -= n;
+    }
+    ok = ok && ~crc == h->crc && storage_file_seek(f, sizeof(ReplayHeader), true);
+    if(!ok) {
+        storage_file_close(f);
+        storage_file_free(f);
+        return false;
+    }
+
+    // A refill queued for the previous ghost may still reach the worker
+    furi_mutex_acquire(g->mutex, FuriWaitForever);
+    g->file = f;
+    g->left = h->len;
+    g->filled = 0;
+    furi_mutex_release(g->mutex);
+    ghost_fill(g);
+    g->front = 0;
+    g->pos = 0;
+    g->consumed = 0;
+    g->last_step = 0;
+    g->pending = false;
+    g->done = false;
+    g->lane = LANE_COUNT / 2;
+    s->ghost = g;
+    return true;
+}
+
+// Returns false when the worker has not filled the next chunk yet
+static bool ghost_byte(RaceGameState* s, Ghost* g, uint8_t* b) {
+    uint8_t bit = 1 << g->front;
+    if(!(__atomic_load_n(&g->filled, __ATOMIC_ACQUIRE) & bit)) return false;
+    *b = g->chunk[g->front][g->pos++];
+    g->consumed++;
+    if(g->pos == g->len[g->front]) {
+        // Hand it back for refilling and carry on with the other one
+        __atomic_fetch_and(&g->filled, ~bit, __ATOMIC_RELEASE);
+        g->front ^= 1;
+        g->pos = 0;
+        Persist* p = s->persist;
+        furi_mutex_acquire(p->mutex, FuriWaitForever);
+        persist_queue(p, PersistGhost);
+        furi_mutex_release(p->mutex);
+    }
+    return true;
+}
+
+// Decodes the next lane event, as replay_fetch() does in the core
+static bool ghost_fetch(RaceGameState* s, Ghost* g) {
+    uint8_t b;
+    while(g->consumed < g->hdr.len) {
+        if(!ghost_byte(s, g, &b)) return false;
+        g->last_step += b >> 2;
+        if((b >> 2) != REPLAY_SKIP) {
+            g->next_step = g->last_step;
+            g->next_lane = b & (LANE_MAX - 1);
+            g->pending = true;
             return true;
+        }
     }
+    g->done = true; // Its last event marks the crash that ended it
     return false;
 }
 
-// ─── Coin / Power-Up Collection ─────────────────────────────────────────────
-
-static void check_collections(RaceGameState* s) {
-    int16_t px = car_lx(s->player_lane);
-
-    // Coins
-    for(int i = 0; i < MAX_COINS; i++) {
-        if(!s->coins[i].alive) continue;
-        int16_t cx = car_lx(s->coins[i].lane);
-        bool magnet_pull = s->magnet_ticks > 0 && abs(s->coins[i].y - PLAYER_Y) < 30;
-        bool touch = (px < cx + 8) && (px + CAR_W > cx) &&
-                     (PLAYER_Y < s->coins[i].y + 8) && (PLAYER_Y + CAR_H > s->coins[i].y);
-        if(touch || magnet_pull) {
-            if(magnet_pull && !touch) {
-                // Pull toward player
-                s->coins[i].y += (s->coins[i].y < PLAYER_Y) ? 4 : -4;
-                if(s->coins[i].lane < s->player_lane) s->coins[i].lane++;
-                else if(s->coins[i].lane > s->player_lane) s->coins[i].lane--;
-                continue; // Don't collect yet, just pull
-            }
-            s->coins[i].alive = false;
-            s->combo++;
-            s->combo_display = 15;
-            uint32_t pts = 25 * (s->combo > 1 ? s->combo : 1);
-            s->score += pts;
-            play_sound(s, 1200 + s->combo * 100, 0.8f, 25);
-        }
+// Applies the lane changes the ghost made up to the current step
+static void ghost_update(RaceGameState* s) {
+    Ghost* g = s->ghost;
+    while(!g->done) {
+        if(!g->pending && !ghost_fetch(s, g)) break;
+        if(g->next_step >= s->sim.tick_count) break;
+        g->lane = g->next_lane;
+        g->pending = false;
     }
+}
 
-    // Power-ups
-    for(int i = 0; i < MAX_POWERUPS; i++) {
-        if(!s->powerups[i].alive) continue;
-        int16_t ppx = car_lx(s->powerups[i].lane);
-        if((px < ppx + 8) && (px + CAR_W > ppx) &&
-           (PLAYER_Y < s->powerups[i].y + 8) && (PLAYER_Y + CAR_H > s->powerups[i].y)) {
-            s->powerups[i].alive = false;
-            play_sound(s, 660, 0.8f, 40);
-            switch(s->powerups[i].type) {
-            case PwShield:
-                s->shield_ticks = 50;
-                break;
-            case PwMagnet:
-                s->magnet_ticks = 60;
-                break;
-            case PwFuel:
-                if(s->lives < MAX_LIVES) s->lives++;
-                break;
-            }
-        }
+// ─── Platform Shim ──────────────────────────────────────────────────────────
+
+static uint32_t hal_now_ms(void* ctx) {
+    UNUSED(ctx);
+    return (uint64_t)furi_get_tick() * 1000 / furi_kernel_get_tick_frequency();
+}
+
+static void hal_sound(void* ctx, RaceSound id, int16_t pitch) {
+    play_sound(ctx, id, pitch);
+}
+
+static void hal_haptic(void* ctx, RaceHaptic id) {
+    vibrate(ctx, id);
+}
+
+static void hal_game_over(void* ctx, const RaceSim* sim) {
+    RaceGameState* s = ctx;
+    s->state = StateGameOver;
+    furi_timer_stop(s->timer);
+    // A new best replaces the ghost file, which storage won't do while it's open
+    ghost_close(s);
+    if(!sim->playback) {
+        save_run(s);
+        replay_save(s, s->rank == 0 && !sim->replay.full);
     }
 }
 
-// ─── Spawning ───────────────────────────────────────────────────────────────
+// ─── Game ───────────────────────────────────────────────────────────────────
 
-static void spawn_obstacle(RaceGameState* s) {
-    for(int i = 0; i < MAX_OBS; i++) {
-        if(!s->obstacles[i].alive) {
-            s->obstacles[i].alive = true;
-            s->obstacles[i].y = -18;
-            s->obstacles[i].lane = rand() % LANE_COUNT;
+static void game_start(RaceGameState* s) {
+    ghost_close(s);
+    s->rank = RANK_NONE;
+    race_sim_start(&s->sim, s->difficulty, DWT->CYCCNT);
+    s->state = StatePlaying;
+    furi_timer_start(s->timer, FRAME_MS);
+}
 
-            // Boss truck every 5 levels
-            if(s->level > 0 && s->level % 5 == 0 && (rand() % 4) == 0) {
-                s->obstacles[i].type = ObsTruck;
-                s->obstacles[i].lane = 1; // Center
-            } else if(rand() % 3 == 0) {
-                s->obstacles[i].type = ObsMoto;
-            } else {
-                s->obstacles[i].type = ObsSedan;
-            }
-            break;
-        }
+// Re-runs the last recorded run at the difficulty it was played on
+static bool game_start_replay(RaceGameState* s) {
+    ghost_close(s);
+    if(!replay_load(s)) return false;
+    s->rank = RANK_NONE;
+    race_sim_start_playback(&s->sim);
+    s->high_score = s->save.top[s->sim.difficulty][0];
+    s->state = StatePlaying;
+    furi_timer_start(s->timer, FRAME_MS);
+    return true;
+}
+
+// Races the best run at the menu difficulty, through the same traffic
+static bool game_start_ghost(RaceGameState* s) {
+    if(!ghost_open(s, s->difficulty)) return false;
+    s->rank = RANK_NONE;
+    race_sim_start(&s->sim, s->difficulty, s->ghost->hdr.seed);
+    s->state = StatePlaying;
+    furi_timer_start(s->timer, FRAME_MS);
+    return true;
+}
+
+static void game_to_menu(RaceGameState* s) {
+    furi_timer_stop(s->timer);
+    ghost_close(s);
+    s->state = StateMenu;
+    // Playback or a resumed run may have shown another difficulty's best
+    s->high_score = s->save.top[s->difficulty][0];
+    mark_dirty(s);
+}
+
+// The run stays in place in s->sim; nothing is copied
+static void game_pause(RaceGameState* s) {
+    furi_timer_stop(s->timer);
+    race_sim_pause(&s->sim);
+    s->state = StatePaused;
+    s->back_held = true;
+    mark_dirty(s);
+}
+
+static void game_resume(RaceGameState* s) {
+    if(!race_sim_resume(&s->sim, &s->hal)) {
+        game_to_menu(s);
+        return;
     }
+    s->state = StatePlaying;
+    furi_timer_start(s->timer, FRAME_MS);
+    mark_dirty(s);
 }
 
-static void spawn_coin(RaceGameState* s) {
-    for(int i = 0; i < MAX_COINS; i++) {
-        if(!s->coins[i].alive) {
-            s->coins[i].alive = true;
-            s->coins[i].y = -12;
-            s->coins[i].lane = rand() % LANE_COUNT;
-            break;
-        }
+// Buffered; the sim applies it at the step the key was pressed in
+static void change_lane(RaceGameState* s, int8_t dir) {
+    if(s->state == StatePlaying) race_sim_input(&s->sim, dir);
+}
+
+// Hold-to-slide: queue moves up to the road edge, one lane per step
+static void slide_lane(RaceGameState* s, int8_t dir) {
+    for(int i = 1; i < LANE_COUNT; i++) change_lane(s, dir);
+}
+
+static void game_frame(RaceGameState* s) {
+    if(s->state != StatePlaying) return; // Tick pending across a pause
+    RaceSim* sim = &s->sim;
+    memset(sim->prof_cycles, 0, sizeof(sim->prof_cycles));
+    if(!race_sim_frame(sim)) return;
+    if(s->ghost) ghost_update(s);
+    mark_dirty(s);
+    if(s->profiler)
+        for(int i = 0; i < ProfCoreCount; i++) prof_add(&s->sim_prof[i], sim->prof_cycles[i]);
+}
+
+// ─── Bench ──────────────────────────────────────────────────────────────────
+// Hidden: hold and release Left in the menu. Runs the core headless on the game loop
+// thread and shows the timings; the abandoned run state is reused.
+
+static uint32_t bench_clock(void) {
+    return DWT->CYCCNT;
+}
+
+static void game_bench(RaceGameState* s) {
+    RaceBenchResult res;
+    size_t heap = memmgr_get_free_heap();
+    race_bench_run(&s->sim, BENCH_STEPS, DWT->CYCCNT, bench_clock, &res);
+
+    BenchReport* b = &s->bench;
+    uint32_t mhz = furi_hal_cortex_instructions_per_microsecond();
+    b->heap_delta = (int32_t)heap - (int32_t)memmgr_get_free_heap();
+    b->runs = res.runs;
+    b->steps_per_sec = res.total_cycles ? (uint64_t)res.steps * mhz * 1000000 / res.total_cycles : 0;
+    b->avg_ns = res.total_cycles * 1000 / mhz / res.steps;
+    b->worst_us = res.worst_cycles / mhz;
+    s->state = StateBench;
+    mark_dirty(s);
+}
+
+// ─── Render Snapshot ────────────────────────────────────────────────────────
+
+// False while the last request is still waiting for the GUI; the finished
+// draw then wakes the loop with LOOP_FLAG_DRAWN
+static bool redraw_due(RenderExchange* x) {
+    if(__atomic_load_n(&x->drawn, __ATOMIC_ACQUIRE) == x->requested) return true;
+    if(hal_now_ms(NULL) - x->requested_ms >= DRAW_STALE_MS) return true; // Covered by another view
+    __atomic_store_n(&x->deferred, true, __ATOMIC_RELEASE);
+    // The draw may have finished in between; a spare wake-up is harmless
+    return __atomic_load_n(&x->drawn, __ATOMIC_ACQUIRE) == x->requested;
+}
+
+static void request_redraw(RenderExchange* x, ViewPort* vp) {
+    x->requested_ms = hal_now_ms(NULL);
+    __atomic_store_n(&x->requested, x->requested + 1, __ATOMIC_RELEASE);
+    view_port_update(vp);
+}
+
+static void publish_snapshot(RaceGameState* s) {
+    RenderExchange* x = s->render;
+    RenderSnapshot* r = &x->buf[x->back];
+
+    const RaceSim* sim = &s->sim;
+    r->state = s->state;
+    r->night_mode = s->night_mode;
+    r->slide = s->slide;
+    r->sound_on = s->sound_on;
+    r->menu_idx = s->menu_idx;
+    r->difficulty = s->difficulty;
+    r->player_lane = sim->player_lane;
+    r->player_visible = sim->invincible_ticks == 0 || sim->tick_count / MS_TO_STEPS(200) % 2 == 0;
+    r->shield = sim->pw_ticks[PwShield] > 0;
+    r->magnet = sim->pw_ticks[PwMagnet] > 0;
+    r->show_combo = sim->combo_display > 0 && sim->combo > 1;
+    r->playback = sim->playback;
+    r->ghost_visible = s->ghost && !s->ghost->done;
+    r->ghost_lane = s->ghost ? s->ghost->lane : 0;
+    r->score = sim->score;
+    r->high_score = s->high_score;
+    r->level = sim->level;
+    r->lives = sim->lives;
+    r->combo = sim->combo;
+    r->rank = s->rank;
+    r->road_scroll = sim->road_scroll;
+    r->tick_count = sim->tick_count;
+    r->bench = s->bench;
+    r->mem = s->mem;
+    r->suite = s->suite;
+    r->profiler = s->profiler;
+    for(int i = 0; i < ProfCoreCount; i++) r->sim_prof[i] = s->sim_prof[i].out;
+    r->missed_ticks = s->missed_ticks;
+
+    const EntityPool* p = &sim->ents;
+    r->obs_count = 0;
+    r->coin_count = 0;
+    r->pw_count = 0;
+    for(uint8_t i = 0; i < p->live_count; i++) {
+        uint8_t e = p->live[i];
+        EntityView v = {.lane = p->lane[e], .y = p->y[e], .type = p->type[e]};
+        if(p->kind[e] == KindObstacle)
+            r->obstacles[r->obs_count++] = v;
+        else if(p->kind[e] == KindCoin)
+            r->coins[r->coin_count++] = v;
+        else
+            r->powerups[r->pw_count++] = v;
     }
+    r->particle_count = sim->particle_count;
+    memcpy(r->particles, sim->particles, sim->particle_count * sizeof(Particle));
+    memcpy(r->scenery, sim->scenery, sizeof(r->scenery));
+
+    x->back = __atomic_exchange_n(&x->ready, x->back | SNAP_FRESH, __ATOMIC_ACQ_REL) & ~SNAP_FRESH;
 }
 
-static void spawn_powerup(RaceGameState* s) {
-    for(int i = 0; i < MAX_POWERUPS; i++) {
-        if(!s->powerups[i].alive) {
-            s->powerups[i].alive = true;
-            s->powerups[i].y = -12;
-            s->powerups[i].lane = rand() % LANE_COUNT;
-            s->powerups[i].type = rand() % 3;
-            break;
+// ─── Scenario Suite ─────────────────────────────────────────────────────────
+// Hidden: hold Left and press Down in the menu. Runs each scripted scenario
+// for SUITE_FRAMES frames through the real draw_callback, one frame at a
+// time, and compares the timings with the stored baseline. Results go to
+// SUITE_CSV_PATH; the first run, or the first after deleting the baseline,
+// becomes the new baseline. Back stops it with nothing saved.
+
+static uint32_t suite_time(uint64_t cycles, uint32_t mhz) {
+    uint64_t t = cycles * SUITE_PER_US / mhz;
+    return t > UINT32_MAX ? UINT32_MAX : t;
+}
+
+// Waits for the frame just requested; false if the GUI never drew it
+static bool suite_wait_drawn(RenderExchange* x) {
+    while(__atomic_load_n(&x->drawn, __ATOMIC_ACQUIRE) != x->requested) {
+        __atomic_store_n(&x->deferred, true, __ATOMIC_RELEASE);
+        if(__atomic_load_n(&x->drawn, __ATOMIC_ACQUIRE) == x->requested) break;
+        if(furi_thread_flags_wait(LOOP_FLAG_DRAWN, FuriFlagWaitAny, DRAW_STALE_MS) & FuriFlagError)
+            return false;
+    }
+    return true;
+}
+
+static bool suite_base_valid(const SuiteRecord* rec) {
+    return rec->magic == SUITE_MAGIC && rec->version == SUITE_VERSION &&
+           rec->count <= RACE_BENCH_SCENARIOS && rec->lanes == LANE_COUNT &&
+           rec->crc == crc32(rec, offsetof(SuiteRecord, crc));
+}
+
+// Matches scenarios by name, so adding one keeps the others comparable
+static void suite_compare(SuiteReport* rep, const SuiteRecord* base) {
+    for(uint8_t i = 0; i < rep->run.count; i++) {
+        const SuiteTiming* t = &rep->run.t[i];
+        rep->delta_pct[i] = SUITE_NO_BASE;
+        for(uint8_t j = 0; base && j < base->count; j++) {
+            const SuiteTiming* b = &base->t[j];
+            int64_t was = (int64_t)b->sim_avg + b->draw_avg;
+            if(!was || strncmp(t->name, b->name, sizeof(t->name))) continue;
+            int64_t d = ((int64_t)t->sim_avg + t->draw_avg - was) * 100 / was;
+            rep->delta_pct[i] = d > INT32_MAX ? INT32_MAX : d; // Never below -100
         }
     }
 }
 
-// ─── Game Tick ───────────────────────────────────────────────────────────────
+static void suite_finish(RaceGameState* s) {
+    SuiteReport* rep = &s->suite;
+    SuiteRecord* run = &rep->run;
+    run->magic = SUITE_MAGIC;
+    run->version = SUITE_VERSION;
+    run->count = RACE_BENCH_SCENARIOS;
+    run->lanes = LANE_COUNT;
+    run->crc = crc32(run, offsetof(SuiteRecord, crc));
+
+    Persist* p = s->persist;
+    SuiteRecord base;
+    bool has_base = persist_read(p->storage, SUITE_BASE_PATH, &base, sizeof(base)) && suite_base_valid(&base);
+    suite_compare(rep, has_base ? &base : NULL);
+    rep->new_base = !has_base;
+
+    furi_mutex_acquire(p->mutex, FuriWaitForever);
+    p->suite = *run;
+    p->suite_base = !has_base;
+    persist_queue(p, PersistSuite);
+    furi_mutex_release(p->mutex);
+}
 
-static void game_tick(RaceGameState* s) {
-    if(s->state != StatePlaying) return;
+typedef enum { SuiteFrameDrawn, SuiteFrameDropped, SuiteFrameStop } SuiteFrame;
 
-    s->tick_count++;
-    s->road_scroll += 3;
-    if(s->road_scroll >= DASH_TOTAL) s->road_scroll -= DASH_TOTAL;
+// Puts the frame just published on screen, setting *cycles when it's drawn
+typedef SuiteFrame (*SuiteShow)(RaceGameState* s, uint32_t* cycles);
 
-    if(s->invincible_ticks > 0) s->invincible_ticks--;
-    if(s->shield_ticks > 0) s->shield_ticks--;
-    if(s->magnet_ticks > 0) s->magnet_ticks--;
-    if(s->combo_display > 0) s->combo_display--;
+static uint64_t suite_total(const SuiteTiming* t) {
+    return (uint64_t)t->sim_avg + t->draw_avg;
+}
 
-    update_particles(s);
+// Runs every scenario `passes` times and keeps each one's fastest pass in
+// s->suite.run. Shared with the host build, which only swaps `show`.
+// False if `show` stopped it.
+static bool suite_run(RaceGameState* s, SuiteShow show, uint8_t passes) {
+    SuiteReport* rep = &s->suite;
+    uint32_t mhz = furi_hal_cortex_instructions_per_microsecond();
+    rep->dropped = 0;
+
+    for(uint8_t i = 0; i < RACE_BENCH_SCENARIOS; i++) {
+        const RaceBenchScenario* sc = &race_bench_scenarios[i];
+        SuiteTiming* best = &rep->run.t[i];
+        for(uint8_t pass = 0; pass < passes; pass++) {
+            uint64_t sim_sum = 0, draw_sum = 0;
+            uint32_t sim_max = 0, draw_max = 0;
+            uint16_t drawn = 0;
+
+            race_bench_scenario_start(&s->sim, sc, SUITE_SEED);
+            for(uint16_t f = 0; f < SUITE_FRAMES; f++) {
+                uint32_t c = race_bench_scenario_steps(&s->sim, sc, SUITE_STEPS, bench_clock, NULL);
+                sim_sum += c;
+                if(c > sim_max) sim_max = c;
+
+                publish_snapshot(s);
+                uint32_t d = 0;
+                SuiteFrame shown = show(s, &d);
+                if(shown == SuiteFrameStop) return false;
+                if(shown == SuiteFrameDropped) {
+                    rep->dropped++;
+                    continue;
+                }
+                draw_sum += d;
+                if(d > draw_max) draw_max = d;
+                drawn++;
+            }
 
-    // Move scenery
-    for(int i = 0; i < MAX_SCENERY; i++) {
-        s->scenery[i].y += 2;
-        if(s->scenery[i].y > SCREEN_H + 5) {
-            s->scenery[i].y = -(rand() % 20);
-            s->scenery[i].side = rand() % 2;
-            s->scenery[i].type = rand() % 2;
+            SuiteTiming t;
+            snprintf(t.name, sizeof(t.name), "%s", sc->name);
+            t.sim_avg = suite_time(sim_sum / SUITE_FRAMES, mhz);
+            t.sim_max = suite_time(sim_max, mhz);
+            t.draw_avg = drawn ? suite_time(draw_sum / drawn, mhz) : 0;
+            t.draw_max = suite_time(draw_max, mhz);
+            if(!pass || suite_total(&t) < suite_total(best)) *best = t;
         }
     }
+    return true;
+}
 
-    // Move obstacles
-    int spd = 3 + (s->level / 2);
-    for(int i = 0; i < MAX_OBS; i++) {
-        if(!s->obstacles[i].alive) continue;
-        int move = spd;
-        if(s->obstacles[i].type == ObsMoto) move += 1; // Motos are faster
-        if(s->obstacles[i].type == ObsTruck) move -= 1; // Trucks are slower
-        s->obstacles[i].y += move;
-        int16_t oh = (s->obstacles[i].type == ObsTruck) ? 16 : 12;
-        if(s->obstacles[i].y > SCREEN_H + oh) {
-            s->obstacles[i].alive = false;
-            s->score += 10;
-        }
-    }
+// Redraws through the GUI and waits for it; Back stops the suite
+static SuiteFrame suite_show(RaceGameState* s, uint32_t* cycles) {
+    RenderExchange* x = s->render;
+    request_redraw(x, s->view_port);
+    bool drawn = suite_wait_drawn(x);
+    if(drawn) *cycles = __atomic_load_n(&x->draw_cycles, __ATOMIC_RELAXED);
+
+    // Only Back is read; the rest mustn't back up the input service
+    bool stop = false;
+    InputEvent ie;
+    while(furi_message_queue_get(s->input_queue, &ie, 0) == FuriStatusOk)
+        if(ie.key == InputKeyBack && ie.type == InputTypePress) stop = true;
+    return stop ? SuiteFrameStop : drawn ? SuiteFrameDrawn : SuiteFrameDropped;
+}
 
-    // Move coins + power-ups
-    for(int i = 0; i < MAX_COINS; i++) {
-        if(s->coins[i].alive) {
-            s->coins[i].y += spd;
-            if(s->coins[i].y > SCREEN_H) s->coins[i].alive = false;
-        }
+// Runs on the game loop thread; the abandoned run state is reused
+static void game_suite(RaceGameState* s) {
+    s->state = StatePlaying; // Scenarios are drawn as runs
+    bool done = suite_run(s, suite_show, 1);
+
+    s->sim.running = false;
+    s->sim.hal = &s->hal;
+    s->tool_key = false; // Its release may have been drained above
+    if(done) {
+        suite_finish(s);
+        s->state = StateSuite;
+    } else {
+        s->back_held = true;
+        s->state = StateMenu;
     }
-    for(int i = 0; i < MAX_POWERUPS; i++) {
-        if(s->powerups[i].alive) {
-            s->powerups[i].y += spd;
-            if(s->powerups[i].y > SCREEN_H) s->powerups[i].alive = false;
-        }
+    mark_dirty(s);
+}
+
+// ─── Input ──────────────────────────────────────────────────────────────────
+
+// OK resumes; Back goes to the menu, or held, quits keeping the run
+static bool paused_input(RaceGameState* s, const InputEvent* ie) {
+    if(ie->key == InputKeyOk && ie->type == InputTypePress) {
+        game_resume(s);
+    } else if(ie->key == InputKeyBack && ie->type == InputTypeLong) {
+        s->suspend = true;
+        return false;
+    } else if(ie->key == InputKeyBack && ie->type == InputTypeShort) {
+        game_to_menu(s);
     }
+    return true;
+}
 
-    // Spawn
-    uint8_t si = diff_spawn[s->difficulty];
-    if(s->tick_count % si == 0) spawn_obstacle(s);
-    if(s->tick_count % 18 == 0) spawn_coin(s);
-    if(s->tick_count % 60 == 0) spawn_powerup(s);
-
-    // Collection
-    check_collections(s);
-
-    // Collision (skip if shield or invincible)
-    if(s->invincible_ticks == 0 && s->shield_ticks == 0 && check_collision(s)) {
-        s->lives--;
-        s->combo = 0; // Reset combo on hit
-        spawn_particles(s, car_lx(s->player_lane) + CAR_W / 2, PLAYER_Y + CAR_H / 2);
-        vibrate(80);
-        play_sound(s, 100, 1.0f, 80);
-
-        if(s->lives == 0) {
-            s->state = StateGameOver;
-            furi_timer_stop(s->timer);
-            vibrate(200);
-            play_sound(s, 80, 1.0f, 200);
-            save_high_score(s);
-            return;
+// Hidden tools hang off Left, which the menu doesn't use: held, Up opens the
+// memory report and Down runs the suite; held and released alone, it runs
+// the bench. True if the event was taken.
+static bool tool_input(RaceGameState* s, const InputEvent* ie) {
+    if(ie->key == InputKeyLeft && ie->type == InputTypeRelease) {
+        bool bench = s->tool_key && s->tool_long && !s->tool_used;
+        s->tool_key = false;
+        if(bench && s->state == StateMenu) game_bench(s);
+        return bench;
+    }
+    if(s->state != StateMenu) return false;
+    if(ie->key == InputKeyLeft) {
+        if(ie->type == InputTypePress) {
+            s->tool_key = true;
+            s->tool_long = false;
+            s->tool_used = false;
+        } else if(ie->type == InputTypeLong) {
+            s->tool_long = true;
         }
-        s->invincible_ticks = 20;
+        return true;
     }
+    if(!s->tool_key || (ie->key != InputKeyUp && ie->key != InputKeyDown)) return false;
+    if(ie->type == InputTypePress && !s->tool_used) {
+        s->tool_used = true;
+        if(ie->key == InputKeyUp)
+            mem_report(s);
+        else
+            game_suite(s);
+    }
+    return true; // No navigation while Left is held
+}
+
+// Returns false when the app should exit
+static bool handle_input(RaceGameState* s, const InputEvent* ie) {
+    if(ie->key == InputKeyBack && s->back_held) {
+        // Still the press that paused or stopped the suite
+        if(ie->type == InputTypeRelease) s->back_held = false;
+    } else if(tool_input(s, ie)) {
+        // Hidden tool key
+    } else if(s->state == StatePaused) {
+        return paused_input(s, ie);
+    } else if(ie->type == InputTypeLong && ie->key == InputKeyRight && s->state == StateMenu) {
+        profiler_toggle(s);
+    } else if(s->slide && s->state == StatePlaying && (ie->key == InputKeyLeft || ie->key == InputKeyRight) &&
+              (ie->type == InputTypeLong || ie->type == InputTypeRepeat)) {
+        // Sliding replaces key repeat
+        if(ie->type == InputTypeLong) slide_lane(s, ie->key == InputKeyLeft ? -1 : 1);
+    } else if(ie->type == InputTypePress || ie->type == InputTypeRepeat) {
+        switch(ie->key) {
+        case InputKeyBack:
+            if(s->state == StatePlaying) {
+                game_pause(s);
+            } else {
+                return false;
+            }
+            break;
+
+        case InputKeyOk:
+            if(s->state == StateMenu) {
+                if(s->menu_idx == MenuStart) game_start(s);
+                else if(s->menu_idx == MenuSound) s->sound_on = !s->sound_on;
+                else if(s->menu_idx == MenuNight) s->night_mode = !s->night_mode;
+                else if(s->menu_idx == MenuSlide) s->slide = !s->slide;
+                else if(s->menu_idx == MenuDiff) {
+                    s->difficulty = (s->difficulty + 1) % DIFF_COUNT;
+                    s->high_score = s->save.top[s->difficulty][0];
+                } else if(s->menu_idx == MenuReplay && !game_start_replay(s))
+                    break; // No valid replay yet
+                else if(s->menu_idx == MenuGhost && !game_start_ghost(s))
+                    break; // No best run on this difficulty yet
+                if(s->menu_idx == MenuSound || s->menu_idx == MenuNight || s->menu_idx == MenuSlide ||
+                   s->menu_idx == MenuDiff)
+                    save_commit(s);
+                mark_dirty(s);
+            } else if(
+                s->state == StateGameOver || s->state == StateBench || s->state == StateSuite ||
+                s->state == StateMemory) {
+                game_to_menu(s);
+            }
+            break;
+
+        case InputKeyUp:
+            if(s->state == StateMenu) {
+                s->menu_idx--;
+                if(s->menu_idx < 0) s->menu_idx = MenuCount - 1;
+                mark_dirty(s);
+            }
+            break;
+
+        case InputKeyDown:
+            if(s->state == StateMenu) {
+                s->menu_idx = (s->menu_idx + 1) % MenuCount;
+                mark_dirty(s);
+            }
+            break;
+
+        case InputKeyLeft:
+            change_lane(s, -1);
+            break;
+
+        case InputKeyRight:
+            change_lane(s, 1);
+            break;
 
-    // Level up
-    uint8_t nl = s->score / 200;
-    if(nl > 9) nl = 9;
-    if(nl > s->level) {
-        s->level = nl;
-        uint16_t min_spd = diff_min_speed[s->difficulty];
-        s->speed = diff_speed[s->difficulty] - s->level * 8;
-        if(s->speed < min_spd) s->speed = min_spd;
-        furi_timer_stop(s->timer);
-        furi_timer_start(s->timer, s->speed);
-        play_sound(s, 880, 1.0f, 40);
+        default:
+            break;
+        }
     }
+    return true;
 }
 
 // ─── Main ───────────────────────────────────────────────────────────────────
 
 int32_t race_game_app(void* p) {
     UNUSED(p);
-    srand(DWT->CYCCNT);
+#ifdef FURI_DEBUG
+    furi_check(race_waves_valid());
+#endif
 
-    RaceGameState* s = malloc(sizeof(RaceGameState));
-    memset(s, 0, sizeof(RaceGameState));
+    RaceArena* arena = malloc(sizeof(RaceArena));
+    memset(arena, 0, sizeof(RaceArena));
+    RaceGameState* s = &arena->game;
     s->state = StateMenu;
-    s->sound_on = true;
-    s->night_mode = false;
-    s->difficulty = DiffNormal;
     s->menu_idx = 0;
-    s->lives = INITIAL_LIVES;
-
-    load_high_score(s);
-
-    FuriMessageQueue* q = furi_message_queue_alloc(8, sizeof(GameEvent));
-    s->timer = furi_timer_alloc(timer_callback, FuriTimerTypePeriodic, q);
+    s->sim.lives = INITIAL_LIVES;
+    s->rank = RANK_NONE;
+    s->hal = (RaceHal){
+        .now_ms = hal_now_ms,
+        .sound = hal_sound,
+        .haptic = hal_haptic,
+        .game_over = hal_game_over,
+        .ctx = s,
+    };
+    s->sim.hal = &s->hal;
+
+    s->persist = &arena->persist;
+    persist_init(s->persist);
+    load_save(s);
+    if(suspend_load(s)) {
+        s->state = StatePaused;
+        s->high_score = s->save.top[s->sim.difficulty][0];
+    }
+    s->sound = &arena->sound;
+    sound_engine_init(s->sound);
+    s->haptics = &arena->haptics;
+    haptic_engine_init(s->haptics);
+    s->render = &arena->render;
+    s->render->ready = 1;
+    s->render->front = 2;
+    road_layer_build(s->render->road_layer);
+    publish_snapshot(s);
+
+    s->loop_thread = furi_thread_get_current_id();
+    s->render->loop_thread = s->loop_thread;
+    s->input_queue = furi_message_queue_alloc(INPUT_QUEUE_LEN, sizeof(InputEvent));
+    s->timer = furi_timer_alloc(timer_callback, FuriTimerTypePeriodic, s);
 
     ViewPort* vp = view_port_alloc();
+    s->view_port = vp;
     view_port_set_orientation(vp, ViewPortOrientationVertical);
-    view_port_draw_callback_set(vp, draw_callback, s);
-    view_port_input_callback_set(vp, input_callback, q);
+    view_port_draw_callback_set(vp, draw_callback, s->render);
+    view_port_input_callback_set(vp, input_callback, s);
 
     Gui* gui = furi_record_open(RECORD_GUI);
     gui_add_view_port(gui, vp, GuiLayerFullscreen);
 
-    GameEvent ev;
     bool running = true;
+    uint32_t drawn_gen = s->frame_gen;
 
     while(running) {
-        furi_check(furi_message_queue_get(q, &ev, FuriWaitForever) == FuriStatusOk);
-
-        if(ev.type == EventTypeKey) {
-            if(ev.input.type == InputTypePress || ev.input.type == InputTypeRepeat) {
-                switch(ev.input.key) {
-                case InputKeyBack:
-                    if(s->state == StatePlaying) {
-                        // Pause: go back to menu
-                        furi_timer_stop(s->timer);
-                        s->state = StateMenu;
-                    } else {
-                        running = false;
-                    }
-                    break;
-
-                case InputKeyOk:
-                    if(s->state == StateMenu) {
-                        if(s->menu_idx == 0) game_init(s);
-                        else if(s->menu_idx == 1) s->sound_on = !s->sound_on;
-                        else if(s->menu_idx == 2) s->night_mode = !s->night_mode;
-                        else if(s->menu_idx == 3) s->difficulty = (s->difficulty + 1) % 3;
-                    } else if(s->state == StateGameOver) {
-                        s->state = StateMenu;
-                    }
-                    break;
-
-                case InputKeyUp:
-                    if(s->state == StateMenu) {
-                        s->menu_idx--;
-                        if(s->menu_idx < 0) s->menu_idx = 3;
-                    }
-                    break;
-
-                case InputKeyDown:
-                    if(s->state == StateMenu) {
-                        s->menu_idx = (s->menu_idx + 1) % 4;
-                    }
-                    break;
-
-                case InputKeyLeft:
-                    if(s->state == StatePlaying && s->player_lane > 0) {
-                        s->player_lane--;
-                        play_sound(s, 440, 1.0f, 12);
-                    }
-                    break;
-
-                case InputKeyRight:
-                    if(s->state == StatePlaying && s->player_lane < LANE_COUNT - 1) {
-                        s->player_lane++;
-                        play_sound(s, 440, 1.0f, 12);
-                    }
-                    break;
-
-                default:
-                    break;
-                }
-            }
-        } else if(ev.type == EventTypeTick) {
-            game_tick(s);
+        furi_thread_flags_wait(
+            LOOP_FLAG_TICK | LOOP_FLAG_INPUT | LOOP_FLAG_DRAWN, FuriFlagWaitAny, FuriWaitForever);
+
+        // Input first, so a lane change lands in the very next frame
+        InputEvent ie;
+        while(running && furi_message_queue_get(s->input_queue, &ie, 0) == FuriStatusOk)
+            running = handle_input(s, &ie);
+
+        // The accumulator already covers the elapsed time; extra ticks are only counted
+        uint32_t ticks = __atomic_exchange_n(&s->pending_ticks, 0, __ATOMIC_ACQ_REL);
+        if(running && ticks) {
+            s->missed_ticks += ticks - 1;
+            game_frame(s);
         }
 
-        view_port_update(vp);
+        // Static screens (menu, game over, key releases) cost no redraw, and
+        // frames the display can't keep up with are folded into the next one
+        if(s->frame_gen != drawn_gen && redraw_due(s->render)) {
+            drawn_gen = s->frame_gen;
+            publish_snapshot(s);
+            request_redraw(s->render, vp);
+        }
     }
 
     furi_timer_stop(s->timer);
     furi_timer_free(s->timer);
-    furi_message_queue_free(q);
+    furi_message_queue_free(s->input_queue);
     gui_remove_view_port(gui, vp);
     view_port_free(vp);
     furi_record_close(RECORD_GUI);
-    free(s);
+    haptic_engine_deinit(s->haptics);
+    sound_engine_deinit(s->sound);
+    ghost_close(s);
+    if(s->suspend) suspend_save(s);
+    persist_deinit(s->persist);
+    free(arena);
 
     return 0;
 }
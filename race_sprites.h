@@ -0,0 +1,227 @@
+/*
+ * Sprite atlas for Race Game: 1-bpp XBM bitmaps (LSB first, rows padded to
+ * whole bytes) rasterised from the original canvas primitive drawings.
+ * Set bits are drawn in the foreground color and clear bits are transparent,
+ * so one bitmap serves both day and night. `holes` marks background pixels
+ * inside a sprite that must stay opaque over the road markings. In the
+ * previews, `o` marks pixels the original drawing painted in background.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "race_core.h"
+
+typedef struct {
+    int8_t ox; // X offset from the entity's lane position
+    uint8_t w;
+    uint8_t h;
+    const uint8_t* bits;
+    const uint8_t* holes;
+} Sprite;
+
+/* player: 10x13
+ * ...####...
+ * ...####...
+ * ##.####.##
+ * ##########
+ * ###oooo###
+ * ..#o##o#..
+ * ..######..
+ * ..######..
+ * ##########
+ * ##########
+ * ##########
+ * .########.
+ * .########.
+ */
+static const uint8_t spr_player_bits[] = {
+    0x78, 0x00, 0x78, 0x00, 0x7b, 0x03, 0xff, 0x03, 0x87, 0x03, 0xb4, 0x00, 0xfc, 0x00, 0xfc, 0x00,
+    0xff, 0x03, 0xff, 0x03, 0xff, 0x03, 0xfe, 0x01, 0xfe, 0x01
+};
+
+/* moto: 4x10
+ * .##.
+ * ####
+ * ####
+ * .##.
+ * .##.
+ * .##.
+ * .##.
+ * ####
+ * ####
+ * .##.
+ */
+static const uint8_t spr_moto_bits[] = {
+    0x06, 0x0f, 0x0f, 0x06, 0x06, 0x06, 0x06, 0x0f, 0x0f, 0x06
+};
+
+/* sedan: 10x12
+ * .########.
+ * .########.
+ * ##oooooo##
+ * ##oooooo##
+ * ##oooooo##
+ * .########.
+ * .########.
+ * .########.
+ * .########.
+ * ##########
+ * ##########
+ * ##########
+ */
+static const uint8_t spr_sedan_bits[] = {
+    0xfe, 0x01, 0xfe, 0x01, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0xfe, 0x01, 0xfe, 0x01, 0xfe, 0x01,
+    0xfe, 0x01, 0xff, 0x03, 0xff, 0x03, 0xff, 0x03
+};
+
+/* truck: 22x16
+ * .####################.
+ * .####################.
+ * ####oooooooooooooo####
+ * ####oooooooooooooo####
+ * ####oooooooooooooo####
+ * .###oooooooooooooo###.
+ * .###oooooooooooooo###.
+ * .###oooooooooooooo###.
+ * .####################.
+ * .####################.
+ * .##ooooooo##ooooooo##.
+ * ###ooooooo##ooooooo###
+ * ###ooooooo##ooooooo###
+ * ######################
+ * .####################.
+ * .####################.
+ */
+static const uint8_t spr_truck_bits[] = {
+    0xfe, 0xff, 0x1f, 0xfe, 0xff, 0x1f, 0x0f, 0x00, 0x3c, 0x0f, 0x00, 0x3c, 0x0f, 0x00, 0x3c, 0x0e,
+    0x00, 0x1c, 0x0e, 0x00, 0x1c, 0x0e, 0x00, 0x1c, 0xfe, 0xff, 0x1f, 0xfe, 0xff, 0x1f, 0x06, 0x0c,
+    0x18, 0x07, 0x0c, 0x38, 0x07, 0x0c, 0x38, 0xff, 0xff, 0x3f, 0xfe, 0xff, 0x1f, 0xfe, 0xff, 0x1f
+};
+static const uint8_t spr_truck_holes[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0xff, 0x03, 0xf0, 0xff, 0x03, 0xf0, 0xff, 0x03, 0xf0,
+    0xff, 0x03, 0xf0, 0xff, 0x03, 0xf0, 0xff, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0xf3,
+    0x07, 0xf8, 0xf3, 0x07, 0xf8, 0xf3, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/* coin_a: 8x8
+ * ........
+ * ...###..
+ * ..#...#.
+ * .#.....#
+ * .#..#..#
+ * .#.....#
+ * ..#...#.
+ * ...###..
+ */
+static const uint8_t spr_coin_a_bits[] = {
+    0x00, 0x38, 0x44, 0x82, 0x92, 0x82, 0x44, 0x38
+};
+
+/* coin_b: 8x8
+ * ........
+ * ...###..
+ * ..#...#.
+ * .#.#...#
+ * .#.....#
+ * .#...#.#
+ * ..#...#.
+ * ...###..
+ */
+static const uint8_t spr_coin_b_bits[] = {
+    0x00, 0x38, 0x44, 0x8a, 0x82, 0xa2, 0x44, 0x38
+};
+
+/* shield: 8x8
+ * .#######
+ * .#.....#
+ * .#.###.#
+ * .#.#...#
+ * .#.###.#
+ * .#...#.#
+ * .#.###.#
+ * .#######
+ */
+static const uint8_t spr_shield_bits[] = {
+    0xfe, 0x82, 0xba, 0x8a, 0xba, 0xa2, 0xba, 0xfe
+};
+
+/* magnet: 8x8
+ * .#######
+ * .#.....#
+ * .##...##
+ * .###.###
+ * .##.#.##
+ * .##...##
+ * .##...##
+ * .#######
+ */
+static const uint8_t spr_magnet_bits[] = {
+    0xfe, 0x82, 0xc6, 0xee, 0xd6, 0xc6, 0xc6, 0xfe
+};
+
+/* fuel: 8x8
+ * .#######
+ * .#.....#
+ * .#..#..#
+ * .#..#..#
+ * .#######
+ * .#..#..#
+ * .#..#..#
+ * .#######
+ */
+static const uint8_t spr_fuel_bits[] = {
+    0xfe, 0x82, 0x92, 0x92, 0xfe, 0x92, 0x92, 0xfe
+};
+
+/* tree: 5x5
+ * ..#..
+ * .###.
+ * #####
+ * ..#..
+ * ..#..
+ */
+static const uint8_t spr_tree_bits[] = {
+    0x04, 0x0e, 0x1f, 0x04, 0x04
+};
+
+/* pole: 5x5
+ * #####
+ * ..#..
+ * ..#..
+ * ..#..
+ * ..#..
+ */
+static const uint8_t spr_pole_bits[] = {
+    0x1f, 0x04, 0x04, 0x04, 0x04
+};
+
+/* heart: 5x5
+ * .#.#.
+ * #####
+ * #####
+ * .###.
+ * ..#..
+ */
+static const uint8_t spr_heart_bits[] = {
+    0x0a, 0x1f, 0x1f, 0x0e, 0x04
+};
+
+#define SPRITE(n, x, w, h) {x, w, h, spr_##n##_bits, NULL}
+
+static const Sprite spr_player = SPRITE(player, 0, 10, 13);
+static const Sprite spr_moto = SPRITE(moto, 3, 4, 10);
+static const Sprite spr_sedan = SPRITE(sedan, 0, 10, 12);
+// The truck is centered on the lanes it covers
+static const Sprite spr_truck = {TRUCK_DX(22), 22, 16, spr_truck_bits, spr_truck_holes};
+static const Sprite spr_coin[2] = {SPRITE(coin_a, 0, 8, 8), SPRITE(coin_b, 0, 8, 8)};
+static const Sprite spr_powerup[3] = {
+    SPRITE(shield, 0, 8, 8),
+    SPRITE(magnet, 0, 8, 8),
+    SPRITE(fuel, 0, 8, 8),
+};
+static const Sprite spr_scenery[2] = {SPRITE(tree, 0, 5, 5), SPRITE(pole, 0, 5, 5)};
+static const Sprite spr_heart = SPRITE(heart, 0, 5, 5);
+
+#undef SPRITE